@@ -1,13 +1,18 @@
 #include "ast.hpp"
 
-void AstNode::setloc(std::size_t line, const std::string& file)
+void AstNode::setloc(const SourceLocation& l)
 {
-    line_no = line;
-    filename = file;
+    loc = l;
 }
 
-Program::Program(const Classes& c)
-    : classes(c)
+VarBinding::VarBinding(Kind k, std::size_t idx)
+    : kind(k), index(idx)
+{
+
+}
+
+Program::Program(Classes c)
+    : classes(std::move(c))
 {
 
 }
@@ -17,8 +22,8 @@ void Program::accept(AstNodeVisitor& visitor)
     visitor.visit(*this);
 }
 
-Class::Class(const Symbol& cname, const Symbol& super, const Attributes& attr, const Methods& funcs)
-    : name(cname), parent(super), attributes(attr), methods(funcs)
+Class::Class(const Symbol& cname, const Symbol& super, Attributes attr, Methods funcs)
+    : name(cname), parent(super), attributes(std::move(attr)), methods(std::move(funcs)), num_init_locals(0)
 {
 
 }
@@ -42,8 +47,9 @@ void Attribute::accept(AstNodeVisitor& visitor)
 }
 
 Method::Method(const Symbol& mname, const Symbol& ret, 
-        const Formals& formals, const ExpressionPtr& expr)
-    : name(mname), return_type(ret), params(formals), body(expr)
+        Formals formals, const ExpressionPtr& expr)
+    : name(mname), return_type(ret), params(std::move(formals)), body(expr), source(nullptr),
+      num_locals(0)
 {
 
 }
@@ -65,7 +71,7 @@ void Formal::accept(AstNodeVisitor& visitor)
 }
 
 StringConst::StringConst(const Symbol& tok)
-    : token(tok)
+    : token(tok), index(0)
 {
 
 }
@@ -76,7 +82,7 @@ void StringConst::accept(AstNodeVisitor& visitor)
 }
 
 IntConst::IntConst(const Symbol& tok)
-    : token(tok)
+    : token(tok), index(0)
 {
 
 }
@@ -142,8 +148,8 @@ void Assign::accept(AstNodeVisitor& visitor)
     visitor.visit(*this);
 }
 
-Block::Block(const Expressions& block)
-    : body(block)
+Block::Block(Expressions block)
+    : body(std::move(block))
 {
 
 }
@@ -277,8 +283,8 @@ void Not::accept(AstNodeVisitor& visitor)
 }
 
 StaticDispatch::StaticDispatch(const ExpressionPtr& objexpr, const Symbol& stype, 
-        const Symbol& func, const Expressions& act)
-   : obj(objexpr), type_decl(stype), method(func), actual(act)
+        const Symbol& func, Expressions act)
+   : obj(objexpr), type_decl(stype), method(func), actual(std::move(act))
 {
 
 }
@@ -289,8 +295,8 @@ void StaticDispatch::accept(AstNodeVisitor& visitor)
 }
 
 DynamicDispatch::DynamicDispatch(const ExpressionPtr& objexpr, 
-        const Symbol& func, const Expressions& act)
-    : obj(objexpr), method(func), actual(act)
+        const Symbol& func, Expressions act)
+    : obj(objexpr), method(func), actual(std::move(act))
 {
 
 }
@@ -312,8 +318,8 @@ void Let::accept(AstNodeVisitor& visitor)
     visitor.visit(*this);
 }
 
-Case::Case(const ExpressionPtr& exp, const Cases& cb)
-    : expr(exp), branches(cb)
+Case::Case(const ExpressionPtr& exp, Cases cb)
+    : expr(exp), branches(std::move(cb))
 {
 
 }
@@ -1,15 +1,18 @@
 // This is where the AST of COOL is defined.
 // The visitor pattern is used to perform operations on AST including
 // type checking and code generation.
+// All nodes are allocated in an AstArena (see astarena.hpp), which owns them,
+// so nodes refer to each other with plain pointers.
 
 #ifndef AST_H
 #define AST_H
 
 #include "symboltable.hpp"
 #include "astnodevisitor.hpp"
+#include "sourcemanager.hpp"
 
+#include <string>
 #include <vector>
-#include <memory>
 
 class AstNodeVisitor;
 
@@ -17,17 +20,37 @@ class AstNodeVisitor;
 class AstNode
 {
 public:
-    // All AST nodes will have a line number and filename which is the line number where
-    // the node is found in the source file
-    std::size_t line_no;
-    std::string filename;
+    // All AST nodes will have a location which is the file and line where
+    // the node is found in the source, see sourcemanager.hpp
+    SourceLocation loc;
 
     AstNode() {}
 
     // Convinience mutator to be used by parser to set the locations for each node
-    void setloc(std::size_t, const std::string&);
+    void setloc(const SourceLocation&);
+};
+typedef AstNode* AstNodePtr;
+
+// Where a variable lives at runtime. The type checker resolves every variable
+// reference to one of these so that the code generator can emit loads and
+// stores without looking up names
+class VarBinding
+{
+public:
+    enum Kind
+    {
+        UNBOUND,
+        SELF_OBJECT, // the self object
+        FORMAL, // index is the position of the parameter
+        LOCAL, // index is the slot in the AR, used by let and case variables
+        ATTRIBUTE // index is the attribute slot in the object layout
+    };
+
+    Kind kind;
+    std::size_t index;
+
+    VarBinding(Kind = UNBOUND, std::size_t = 0);
 };
-typedef std::shared_ptr<AstNode> AstNodePtr;
 
 // Base class of COOL's expressions
 class Expression : public AstNode
@@ -41,7 +64,7 @@ public:
     Expression() {}
     virtual void accept(AstNodeVisitor&) = 0;
 };
-typedef std::shared_ptr<Expression> ExpressionPtr;
+typedef Expression* ExpressionPtr;
 typedef std::vector<ExpressionPtr> Expressions;
 
 class Attribute : public AstNode
@@ -54,7 +77,7 @@ public:
     Attribute(const Symbol&, const Symbol&, const ExpressionPtr&);
     void accept(AstNodeVisitor&);
 };
-typedef std::shared_ptr<Attribute> AttributePtr;
+typedef Attribute* AttributePtr;
 typedef std::vector<AttributePtr> Attributes;
 
 // A Formal in COOL is the same as a method parameter
@@ -67,22 +90,33 @@ public:
     Formal(const Symbol&, const Symbol&);
     void accept(AstNodeVisitor&);
 };
-typedef std::shared_ptr<Formal> FormalPtr;
+typedef Formal* FormalPtr;
 typedef std::vector<FormalPtr> Formals;
 
+// Source of a method body the parser skipped, see lazymethods.hpp. The text
+// runs from after the opening '{' up to and including the closing '}'
+class MethodSource
+{
+public:
+    std::string text;
+    int first_line; // line of the opening '{'
+};
+
 class Method : public AstNode
 {
 public:
     Symbol name;
     Symbol return_type;
     Formals params;
-    ExpressionPtr body;
+    ExpressionPtr body; // nullptr until a skipped body is parsed
+    const MethodSource* source; // set if the parser skipped the body
+    std::size_t num_locals; // number of AR slots needed by let and case variables
 
-    Method(const Symbol&, const Symbol&, const Formals&,
+    Method(const Symbol&, const Symbol&, Formals,
             const ExpressionPtr&);
     void accept(AstNodeVisitor&);
 };
-typedef std::shared_ptr<Method> MethodPtr;
+typedef Method* MethodPtr;
 typedef std::vector<MethodPtr> Methods;
 
 class Class : public AstNode
@@ -92,11 +126,12 @@ public:
     Symbol parent;
     Attributes attributes;
     Methods methods;
+    std::size_t num_init_locals; // number of AR slots needed by the attribute initializers
 
-    Class(const Symbol&, const Symbol&, const Attributes&, const Methods&);
+    Class(const Symbol&, const Symbol&, Attributes, Methods);
     void accept(AstNodeVisitor&);
 };
-typedef std::shared_ptr<Class> ClassPtr;
+typedef Class* ClassPtr;
 typedef std::vector<ClassPtr> Classes;
 
 // The root of the AST
@@ -105,15 +140,16 @@ class Program : public AstNode
 public:
     Classes classes;
 
-    Program(const Classes&);
+    Program(Classes);
     void accept(AstNodeVisitor&);
 };
-typedef std::shared_ptr<Program> ProgramPtr;
+typedef Program* ProgramPtr;
 
 class StringConst : public Expression
 {
 public:
     Symbol token;
+    std::size_t index; // in the ConstantPool, see constantpool.hpp
 
     StringConst(const Symbol&);
     void accept(AstNodeVisitor&);
@@ -123,6 +159,7 @@ class IntConst : public Expression
 {
 public:
     Symbol token;
+    std::size_t index; // in the ConstantPool, see constantpool.hpp
 
     IntConst(const Symbol&);
     void accept(AstNodeVisitor&);
@@ -161,11 +198,12 @@ public:
     Symbol name;
     Symbol type_decl;
     ExpressionPtr expr;
+    VarBinding binding;
 
     CaseBranch(const Symbol&, const Symbol&, const ExpressionPtr&);
     void accept(AstNodeVisitor&);
 };
-typedef std::shared_ptr<CaseBranch> CaseBranchPtr;
+typedef CaseBranch* CaseBranchPtr;
 typedef std::vector<CaseBranchPtr> Cases;
 
 class Assign : public Expression
@@ -173,6 +211,7 @@ class Assign : public Expression
 public:
     Symbol name;
     ExpressionPtr rhs;
+    VarBinding binding;
 
     Assign(const Symbol&, const ExpressionPtr&);
     void accept(AstNodeVisitor&);
@@ -183,7 +222,7 @@ class Block : public Expression
 public:
     Expressions body;
 
-    Block(const Expressions&);
+    Block(Expressions);
     void accept(AstNodeVisitor&);
 };
 
@@ -308,7 +347,7 @@ public:
     Expressions actual;
 
     StaticDispatch(const ExpressionPtr&, const Symbol&, const Symbol&,
-           const Expressions&);
+           Expressions);
     void accept(AstNodeVisitor&);
 };
 
@@ -320,7 +359,7 @@ public:
     Expressions actual;
 
     DynamicDispatch(const ExpressionPtr&, const Symbol&,
-            const Expressions&);
+            Expressions);
     void accept(AstNodeVisitor&);
 };
 
@@ -331,6 +370,7 @@ public:
     Symbol type_decl;
     ExpressionPtr init;
     ExpressionPtr body;
+    VarBinding binding;
 
     Let(const Symbol&, const Symbol&, const ExpressionPtr&,
             const ExpressionPtr&);
@@ -343,7 +383,7 @@ public:
     ExpressionPtr expr;
     Cases branches;
 
-    Case(const ExpressionPtr&, const Cases&);
+    Case(const ExpressionPtr&, Cases);
     void accept(AstNodeVisitor&);
 };
 
@@ -351,6 +391,7 @@ class Object : public Expression
 {
 public:
     Symbol name;
+    VarBinding binding;
 
     Object(const Symbol&);
     void accept(AstNodeVisitor&);
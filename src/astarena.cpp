@@ -0,0 +1,47 @@
+#include "astarena.hpp"
+
+#include <utility>
+
+AstArena::AstArena()
+    : block_used(BLOCK_SIZE), total_used(0)
+{
+
+}
+
+AstArena::~AstArena()
+{
+    // destroy in reverse order of construction, like automatic objects
+    for (auto it = dtors.rbegin(), end = dtors.rend(); it != end; ++it)
+        it->destroy(it->node);
+}
+
+void* AstArena::allocate(std::size_t size, std::size_t align)
+{
+    std::size_t offset = (block_used + align - 1) & ~(align - 1);
+
+    if (offset + size > BLOCK_SIZE)
+    {
+        // nodes are far smaller than a block, a fresh block always fits one.
+        // blocks from new[] are aligned for any fundamental type
+        blocks.emplace_back(new char[BLOCK_SIZE]);
+        offset = 0;
+    }
+
+    block_used = offset + size;
+    total_used += size;
+    return blocks.back().get() + offset;
+}
+
+void AstArena::splice(AstArena& other)
+{
+    for (auto& block : other.blocks)
+        blocks.emplace(begin(blocks), std::move(block));
+
+    dtors.insert(end(dtors), begin(other.dtors), end(other.dtors));
+    total_used += other.total_used;
+
+    other.blocks.clear();
+    other.dtors.clear();
+    other.block_used = BLOCK_SIZE;
+    other.total_used = 0;
+}
@@ -0,0 +1,72 @@
+// Arena that owns all AST nodes of a compilation.
+// Nodes are bump allocated out of large blocks and are all destroyed at once
+// when the arena goes away, so creating a node is a pointer increment and the
+// tree is referenced with plain pointers instead of reference counted ones.
+
+#ifndef ASTARENA_H
+#define ASTARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class AstArena
+{
+private:
+    static const std::size_t BLOCK_SIZE = 256 * 1024;
+
+    // destructor of a node that has to run when the arena is freed
+    struct Destructor
+    {
+        void* node;
+        void (*destroy)(void*);
+    };
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::size_t block_used; // number of bytes used in blocks.back()
+    std::size_t total_used; // number of bytes used in all blocks
+    std::vector<Destructor> dtors;
+
+    void* allocate(std::size_t, std::size_t);
+
+    template<typename T>
+    static void destroy(void* node)
+    {
+        static_cast<T*>(node)->~T();
+    }
+
+public:
+    AstArena();
+    ~AstArena();
+
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    // constructs a node in the arena, the node lives as long as the arena
+    template<typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        T* node = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        if (!std::is_trivially_destructible<T>::value)
+            dtors.push_back(Destructor { node, &destroy<T> });
+
+        return node;
+    }
+
+    // Takes over all nodes of the other arena, which is left empty. Lets
+    // nodes built in separate arenas, e.g. on different threads, live as
+    // long as this one
+    void splice(AstArena&);
+
+    // number of bytes taken up by nodes
+    std::size_t size() const
+    {
+        return total_used;
+    }
+};
+
+#endif
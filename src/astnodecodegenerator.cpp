@@ -1,19 +1,45 @@
 #include "astnodecodegenerator.hpp"
+#include "constantpool.hpp"
 #include "utility.hpp"
 #include "constants.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <sstream>
-#include <stack>
-
-// defined in main.cpp
-extern ProgramPtr ast_root;
+#include <string>
+#include <vector>
 
 using namespace constants;
 
-AstNodeCodeGenerator::AstNodeCodeGenerator(const std::map<ClassPtr, ClassPtr>& ig,
-        std::ostream& stream)
-    : inherit_graph(ig), os(stream), curr_attr_count(0), while_count(0), if_count(0)
+namespace
+{
+    // the classes are cut into more batches than there are workers, so that
+    // workers done early can help with the rest
+    const std::size_t BATCHES_PER_WORKER = 4;
+
+    // batches with fewer classes than this aren't worth a task of their own
+    const std::size_t MIN_BATCH_SIZE = 16;
+
+    // Classes generated by one task, into a buffer of their own
+    class CodeBatch
+    {
+    public:
+        std::size_t begin;
+        std::size_t end;
+        std::string text;
+
+        CodeBatch(std::size_t b, std::size_t e)
+            : begin(b), end(e)
+        {
+
+        }
+    };
+}
+
+AstNodeCodeGenerator::AstNodeCodeGenerator(ConstantPool& cp, const ClassTable& ct, const ClassLayout& cl,
+        std::ostream& stream, ThreadPool* tp)
+    : constants(cp), class_table(ct), class_layout(cl), os(stream), pool(tp), curr_class_id(ClassTable::NO_CLASS_ID),
+      while_count(0), if_count(0)
 {
 
 }
@@ -300,43 +326,42 @@ void AstNodeCodeGenerator::emit_pop(int num_bytes)
 
 void AstNodeCodeGenerator::code_constants()
 {
-    // Add all class names to the string table so string constants
+    // Add all class names to the pool so string constants
     // will be created for them (for class name table code gen)
-    for (auto& p : inherit_graph)
-        stringtable().add(p.first->name.get_val());
+    for (std::size_t id = 0; id < class_table.size(); ++id)
+        constants.add_string(class_table.get_class(id)->name);
 
-    auto str_consts = stringtable().get_elems();
+    constants.add_string(Symbol()); // add empty string to the pool as this is the
+                                    // default value of a newly allocated string object
 
-    stringtable().add(""); // add empty string to string const table as this is the
-                           // default value of a newly allocated string object
+    const std::vector<Symbol>& strings = constants.get_strings();
 
-    for (auto it = begin(str_consts); it != end(str_consts); ++it)
+    for (std::size_t i = 0; i < strings.size(); ++i)
     {
+        std::string str = strings[i].get_val();
+
         os << "str_const";
-        emit_label(std::to_string(stringtable().get_idx(it->first)).c_str());
+        emit_label(std::to_string(i).c_str());
         emit_word(STR_CLASS_TAG);
 
         // total size of string constant is 4 + number of words required to store the characters
-        emit_word(STR_CONST_BASE + ceil(it->first.size() / 4.0));
+        emit_word(STR_CONST_BASE + ceil(str.size() / 4.0));
         emit_word("String_disptable");
-        emit_word(it->first.size());
-        emit_asciiz(it->first.c_str());
+        emit_word(str.size());
+        emit_asciiz(str.c_str());
         emit_align(2); // align to word boundary (2^2)
     }
 
-    auto int_consts = inttable().get_elems();
+    const std::vector<std::int32_t>& ints = constants.get_ints();
 
-    for (auto it = begin(int_consts); it != end(int_consts); ++it)
+    for (std::size_t i = 0; i < ints.size(); ++i)
     {
         os << "int_const";
-        emit_label(std::to_string(inttable().get_idx(it->first)).c_str());
+        emit_label(std::to_string(i).c_str());
         emit_word(INT_CLASS_TAG);
         emit_word(INT_CONST_SIZE);
         emit_word("Int_disptable");
-
-        int repr;
-        std::stringstream(it->first) >> repr;
-        emit_word(repr);
+        emit_word(ints[i]);
     }
 
     // code gen for boolean constants true and false
@@ -360,10 +385,10 @@ void AstNodeCodeGenerator::code_class_name_table()
 {
     emit_label("class_name_table");
 
-    for (auto it = begin(inherit_graph); it != end(inherit_graph); ++it)
+    for (std::size_t id = 0; id < class_table.size(); ++id)
     {
         std::ostringstream oss;
-        oss << "str_const" << stringtable().get_idx(it->first);
+        oss << "str_const" << constants.add_string(class_table.get_class(id)->name);
         emit_word(oss.str().c_str());
     }
 }
@@ -372,86 +397,27 @@ void AstNodeCodeGenerator::code_prototype_table()
 {
     emit_label("class_prototype_table");
 
-    for (auto it = begin(inherit_graph); it != end(inherit_graph); ++it)
+    for (std::size_t id = 0; id < class_table.size(); ++id)
     {
-        emit_word(it->first + "_prototype");
-        emit_word(it->first + "_init");
+        emit_word(class_table.get_class(id)->name.get_val() + "_prototype");
+        emit_word(class_table.get_class(id)->name.get_val() + "_init");
     }
 }
 */
 
-void AstNodeCodeGenerator::code_dispatch_table(const ClassPtr& class_node)
-{
-    std::map<Symbol, Symbol> mnames; // map of all method names
-    std::stack<ClassPtr> recur; // the methods in the dispatch table must be ordered
-                                // starting from the top of the hierarchy down to the class
-                                // class_node is pointing to
-
-    ClassPtr cptr = class_node;
-
-    // go up the inheritance tree and for each class, push it to the stack (so class Object
-    // will be on the top of the stack after this loop) and add all the method names in mnames.
-    // this is used to check later if a method was overriden
-    while (cptr->name != NOCLASS)
-    {
-        recur.push(cptr);
-
-        for (auto& method : cptr->methods)
-        {
-            if (mnames.find(method->name) == end(mnames))
-                mnames[method->name] = cptr->name;
-        }
-
-        cptr = inherit_graph[cptr];
-    }
-
-    std::size_t dispoffset = 0;
-
-    // go through the stack (goes down the inheritance tree, starting from Object)
-    while (!recur.empty())
-    {
-        ClassPtr head = recur.top();
-
-        // for each method in the current class, if the method is still in the mnames
-        // table (not overriden), add it to the method table with the offset then remove
-        // the method name from mnames so there won't be any duplication if a method
-        // is overriden by a derived class
-        for (auto& method : head->methods)
-        {
-            if (mnames.find(method->name) != end(mnames))
-            {
-                method_tbl[class_node->name][method->name] = dispoffset++;
-                emit_word(mnames[method->name].get_val() + "." + method->name.get_val());
-                mnames.erase(method->name);
-            }
-        }
-
-        recur.pop();
-    }
-}
-
-int AstNodeCodeGenerator::calc_obj_size(const ClassPtr& class_node)
+void AstNodeCodeGenerator::code_dispatch_table(ClassTable::ClassId class_id)
 {
-    int total = 0;
-    ClassPtr curr_class = class_node;
-
-    while (curr_class->name != NOCLASS)
+    // each entry is labeled with the class that implements the method
+    for (std::size_t slot = 0; slot < class_layout.method_count(class_id); ++slot)
     {
-        total += curr_class->attributes.size();
-        curr_class = inherit_graph[curr_class];
+        const ClassLayout::MethodSlot& entry = class_layout.get_method(class_id, slot);
+        emit_word(class_table.get_class(entry.owner)->name.get_val() + "." + entry.method->name.get_val());
     }
-
-    return total;
 }
 
-void AstNodeCodeGenerator::emit_obj_attribs(const ClassPtr& class_node)
+void AstNodeCodeGenerator::emit_obj_attribs(ClassTable::ClassId class_id)
 {
-    if (class_node->name == NOCLASS)
-        return;
-
-    emit_obj_attribs(inherit_graph[class_node]);
-
-    for (auto& attrib : class_node->attributes)
+    for (std::size_t slot = 0; slot < class_layout.attr_count(class_id); ++slot)
         emit_word(0);
 }
 
@@ -459,25 +425,73 @@ void AstNodeCodeGenerator::code_prototype_objects()
 {
     int classtag = 1;
 
-    for (auto& p : inherit_graph)
+    for (std::size_t id = 0; id < class_table.size(); ++id)
     {
-        if (p.first->name == NOCLASS)
-            continue;
+        const ClassPtr& class_node = class_table.get_class(id);
 
-        emit_label(p.first->name.get_val() + "_prototype");
+        emit_label(class_node->name.get_val() + "_prototype");
 
-        if (p.first->name == STRING)
+        if (class_node->name == STRING)
             emit_word(STR_CLASS_TAG);
-        else if (p.first->name == INTEGER)
+        else if (class_node->name == INTEGER)
             emit_word(INT_CLASS_TAG);
-        else if (p.first->name == BOOLEAN)
+        else if (class_node->name == BOOLEAN)
             emit_word(BOOL_CLASS_TAG);
         else
+        {
+            // the tags of String, Int and Bool are fixed, don't hand them out again
+            while (classtag == STR_CLASS_TAG || classtag == INT_CLASS_TAG || classtag == BOOL_CLASS_TAG)
+                ++classtag;
+
             emit_word(classtag++);
+        }
 
-        emit_word(OBJECT_HEADER_SIZE + calc_obj_size(p.first));
-        emit_word(p.first->name.get_val() + "_disptable");
-        emit_obj_attribs(p.first);
+        emit_word(OBJECT_HEADER_SIZE + class_layout.attr_count(id));
+        emit_word(class_node->name.get_val() + "_disptable");
+        emit_obj_attribs(id);
+    }
+}
+
+void AstNodeCodeGenerator::emit_load_var(const VarBinding& var)
+{
+    switch (var.kind)
+    {
+        case VarBinding::SELF_OBJECT:
+            emit_move("a0", "s0");
+            break;
+        case VarBinding::FORMAL:
+            emit_lw("a0", WORD_SIZE * (var.index + 1), "fp");
+            break;
+        case VarBinding::LOCAL:
+            emit_lw("a0", -WORD_SIZE * (var.index + 1), "fp");
+            break;
+        case VarBinding::ATTRIBUTE:
+            emit_lw("a0", WORD_SIZE * (OBJECT_HEADER_SIZE + var.index), "s0");
+            break;
+        case VarBinding::UNBOUND:
+            // the type checker doesn't let an unbound variable through
+            break;
+    }
+}
+
+void AstNodeCodeGenerator::emit_store_var(const VarBinding& var)
+{
+    switch (var.kind)
+    {
+        case VarBinding::FORMAL:
+            emit_sw("a0", WORD_SIZE * (var.index + 1), "fp");
+            break;
+        case VarBinding::LOCAL:
+            emit_sw("a0", -WORD_SIZE * (var.index + 1), "fp");
+            break;
+        case VarBinding::ATTRIBUTE:
+            emit_sw("a0", WORD_SIZE * (OBJECT_HEADER_SIZE + var.index), "s0");
+            break;
+        case VarBinding::SELF_OBJECT:
+        case VarBinding::UNBOUND:
+            // self can't be assigned to, and the type checker doesn't
+            // let an unbound variable through
+            break;
     }
 }
 
@@ -503,36 +517,77 @@ void AstNodeCodeGenerator::emit_initial_data()
 }
 
 
-void AstNodeCodeGenerator::visit(Program& prog)
+void AstNodeCodeGenerator::visit(Program&)
+{
+    code_data();
+    code_classes();
+}
+
+void AstNodeCodeGenerator::code_data()
 {
     emit_initial_data();
     code_constants();
     //code_class_name_table();
     //code_prototype_table();
 
-    for (auto& p : inherit_graph)
+    for (std::size_t id = 0; id < class_table.size(); ++id)
     {
-        if (p.first->name != NOCLASS)
-        {
-            emit_label(p.first->name.get_val() + "_disptable");
-            code_dispatch_table(p.first);
-        }
+        emit_label(class_table.get_class(id)->name.get_val() + "_disptable");
+        code_dispatch_table(id);
     }
 
     code_prototype_objects();
 
     os << ".text\n";
+}
+
+void AstNodeCodeGenerator::code_classes()
+{
+    // the basic classes aren't in the program, only in the class table
+    std::size_t num_classes = class_table.size();
+    std::size_t num_batches = pool ? pool->size() * BATCHES_PER_WORKER : 1;
+    std::size_t batch_size = std::max(MIN_BATCH_SIZE, (num_classes + num_batches - 1) / num_batches);
 
-    for (auto& cs : prog.classes)
-        cs->accept(*this);
+    if (!pool || pool->size() <= 1 || num_classes <= batch_size)
+    {
+        for (std::size_t id = 0; id < num_classes; ++id)
+            class_table.get_class(id)->accept(*this);
+
+        return;
+    }
+
+    std::vector<CodeBatch> batches;
+    for (std::size_t begin = 0; begin < num_classes; begin += batch_size)
+        batches.emplace_back(begin, std::min(begin + batch_size, num_classes));
+
+    for (auto& batch : batches)
+    {
+        CodeBatch* b = &batch;
+        pool->submit([this, b]()
+        {
+            std::ostringstream text;
+            AstNodeCodeGenerator codegen(constants, class_table, class_layout, text);
+
+            for (std::size_t id = b->begin; id < b->end; ++id)
+                class_table.get_class(id)->accept(codegen);
+
+            b->text = text.str();
+        });
+    }
+
+    pool->wait();
+
+    for (auto& batch : batches)
+        os << batch.text;
 }
 
 void AstNodeCodeGenerator::visit(Class& cs)
 {
     // as each class node is traversed, its _init method (akin to constructor)
     // is also generated
-    var_env.enter_scope();
     curr_class = cs.name;
+    curr_class_id = class_table.find(cs.name);
+    while_count = if_count = 0;
     emit_label(cs.name.get_val() + "_init");
     emit_push(AR_BASE_SIZE);
 
@@ -548,9 +603,15 @@ void AstNodeCodeGenerator::visit(Class& cs)
     if (cs.name != OBJECT)
         emit_jal(cs.parent.get_val() + "_init");
 
+    if (cs.num_init_locals > 0)
+        emit_push(cs.num_init_locals);
+
     for (auto& attrib : cs.attributes)
         attrib->accept(*this);
 
+    if (cs.num_init_locals > 0)
+        emit_pop(cs.num_init_locals);
+
     emit_move("a0", "s0");
     emit_lw("fp", 12, "sp");
     emit_lw("s0", 8, "sp");
@@ -558,27 +619,19 @@ void AstNodeCodeGenerator::visit(Class& cs)
     emit_pop(AR_BASE_SIZE);
     emit_jr("ra");
 
-    curr_attr_count = 0;
-
     for (auto& method : cs.methods)
         method->accept(*this);
-
-    var_env.exit_scope();
 }
 
 void AstNodeCodeGenerator::visit(Attribute& attr)
 {
     attr.init->accept(*this);
 
-    ++curr_attr_count;
-    attr_tbl[curr_class][attr.name] = curr_attr_count;
-
     // PRIM_SLOT refers to an attribute of a primitive type (eg. Bool, String, Int)
-    // the current attribute counter is incremented by 2 since the starting offset
-    // for an attribute in the object layout is offset 3 (offstet 0-2 being the headers)
-    // and then multiplied by 4 since there are 4 bytes in a word
+    // the attribute slots start right after the object header and each slot
+    // is one word
     if (attr.type_decl != PRIM_SLOT)
-        emit_sw("a0", WORD_SIZE * (curr_attr_count + 2), "s0");
+        emit_store_var(VarBinding(VarBinding::ATTRIBUTE, class_layout.find_attr(curr_class_id, attr.name)));
 }
 
 void AstNodeCodeGenerator::visit(Formal&)
@@ -591,18 +644,26 @@ void AstNodeCodeGenerator::visit(Method& method)
     if (utility::is_basic_class(curr_class))
         return;
 
-    var_env.enter_scope();
     emit_label(curr_class.get_val() + "." + method.name.get_val());
 
-    emit_sw("ra", 4, "sp");
+    // the method can't be called, its body was never parsed, but the
+    // dispatch tables still refer to it
+    if (!method.body)
+    {
+        emit_jal("Object.abort");
+        return;
+    }
 
-    int curr_offset = 1;
+    emit_sw("ra", 4, "sp");
 
-    for (auto& formal : method.params)
-        var_env.add(formal->name, curr_offset++);
+    if (method.num_locals > 0)
+        emit_push(method.num_locals);
 
     method.body->accept(*this);
 
+    if (method.num_locals > 0)
+        emit_pop(method.num_locals);
+
     // refer to stack frame layout in header file
     std::size_t ar_size = AR_BASE_SIZE + method.params.size();
     emit_lw("fp", ar_size * WORD_SIZE, "sp");
@@ -610,18 +671,16 @@ void AstNodeCodeGenerator::visit(Method& method)
     emit_lw("ra", 4, "sp");
     emit_pop(AR_BASE_SIZE + method.params.size());
     emit_jr("ra");
-
-    var_env.exit_scope();
 }
 
 void AstNodeCodeGenerator::visit(StringConst& str)
 {
-    emit_la("a0", (std::string("str_const") + std::to_string(stringtable().get_idx(str.token.get_val()))).c_str());
+    emit_la("a0", (std::string("str_const") + std::to_string(str.index)).c_str());
 }
 
 void AstNodeCodeGenerator::visit(IntConst& int_const)
 {
-    emit_la("a0", (std::string("int_const") + std::to_string(inttable().get_idx(int_const.token.get_val()))).c_str());
+    emit_la("a0", (std::string("int_const") + std::to_string(int_const.index)).c_str());
 }
 
 void AstNodeCodeGenerator::visit(BoolConst& bool_const)
@@ -653,14 +712,10 @@ void AstNodeCodeGenerator::visit(CaseBranch& branch)
 void AstNodeCodeGenerator::visit(Assign& assign)
 {
     assign.rhs->accept(*this);
-    boost::optional<int> offset(var_env.lookup(assign.name));
 
     // result of evaluating rhs of assignment
     // is expected to be in register $a0
-    // also note that offset is not checked for null
-    // because the semantic analyzer should've caught
-    // any variable misuse by this point
-    emit_sw("a0", *offset, "fp");
+    emit_store_var(assign.binding);
 }
 
 void AstNodeCodeGenerator::visit(Block& block)
@@ -672,34 +727,35 @@ void AstNodeCodeGenerator::visit(Block& block)
 void AstNodeCodeGenerator::visit(If& ifstmt)
 {
     ++if_count;
-    std::string ifcnt(std::to_string(if_count));
+    std::string ifcnt(curr_class.get_val() + "_if" + std::to_string(if_count));
 
     ifstmt.predicate->accept(*this);
 
     emit_la("t1", "bool_const1");
-    emit_beq("a0", "t1", "iftrue" + ifcnt);
+    emit_beq("a0", "t1", ifcnt + "_true");
     ifstmt.iffalse->accept(*this);
-    emit_b("ifend" + ifcnt);
+    emit_b(ifcnt + "_end");
 
-    emit_label("iftrue" + ifcnt);
+    emit_label(ifcnt + "_true");
     ifstmt.iftrue->accept(*this);
 
-    emit_label("ifend" + ifcnt);
+    emit_label(ifcnt + "_end");
 }
 
 void AstNodeCodeGenerator::visit(While& whilestmt)
 {
     ++while_count;
+    std::string whilecnt(curr_class.get_val() + "_while" + std::to_string(while_count));
 
-    emit_label("whileloop" + std::to_string(while_count));
+    emit_label(whilecnt + "_loop");
     whilestmt.predicate->accept(*this);
     emit_la("t1", "bool_const1");
-    emit_bne("a0", "t1", "whileend" + std::to_string(while_count));
+    emit_bne("a0", "t1", whilecnt + "_end");
 
     whilestmt.body->accept(*this);
 
-    emit_b("whileloop" + std::to_string(while_count));
-    emit_label("whileend" + std::to_string(while_count));
+    emit_b(whilecnt + "_loop");
+    emit_label(whilecnt + "_end");
     emit_li("a0", 0);
 }
 
@@ -834,14 +890,17 @@ void AstNodeCodeGenerator::visit(DynamicDispatch& ddisp)
     emit_addiu("fp", "sp", 4);
 
     ddisp.obj->accept(*this);
+    // the type checker has made sure that the method exists
+    int slot = class_layout.find_method(class_table.find(ddisp.obj->type), ddisp.method);
     emit_lw("t1", 8, "a0");
-    emit_lw("t1", method_tbl[ddisp.obj->type][ddisp.method] * WORD_SIZE, "t1");
+    emit_lw("t1", slot * WORD_SIZE, "t1");
     emit_jalr("t1");
 }
 
 void AstNodeCodeGenerator::visit(Let& let)
 {
     let.init->accept(*this);
+    emit_store_var(let.binding);
     let.body->accept(*this);
 }
 
@@ -849,25 +908,15 @@ void AstNodeCodeGenerator::visit(Case& caze)
 {
     caze.expr->accept(*this);
     for (auto& br : caze.branches)
+    {
+        emit_store_var(br->binding);
         br->accept(*this);
+    }
 }
 
 void AstNodeCodeGenerator::visit(Object& obj)
 {
-    if (obj.name == SELF)
-    {
-        emit_move("a0", "s0");
-    }
-    else
-    {
-        // If the object name is not in in the current local scope,
-        // check if it's an attribute of the current class
-        boost::optional<int> offset(var_env.lookup(obj.name));
-        if (offset)
-            emit_lw("a0", *offset, "fp");
-        else
-            emit_lw("a0", WORD_SIZE * (attr_tbl[curr_class][obj.name] + 2), "s0");
-    }
+    emit_load_var(obj.binding);
 }
 
 void AstNodeCodeGenerator::visit(NoExpr&)
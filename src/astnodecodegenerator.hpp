@@ -1,9 +1,18 @@
 // This is where code generation for the AST is done.
+// The data section is emitted first, then the code of each class. The code
+// of a class only depends on the class table and layout, and its labels are
+// numbered per class, so with a thread pool the classes are generated in
+// batches at the same time, each into a buffer of its own, and the buffers
+// are written out in class id order. The output is the same either way.
 
 #ifndef ASTNODECODEGENERATOR_H
 #define ASTNODECODEGENERATOR_H
 
 #include "astnodevisitor.hpp"
+#include "classtable.hpp"
+#include "classlayout.hpp"
+#include "constantpool.hpp"
+#include "threadpool.hpp"
 
 // Visitor that performs code generation for each AST node
 class AstNodeCodeGenerator : public AstNodeVisitor
@@ -67,28 +76,27 @@ private:
              -----------------------
             |    RETURN ADDRESS     | <---- current frame pointer
              -----------------------
+            |        LOCAL1         |
+             -----------------------
+            |        LOCALN         |
+             -----------------------
+
+       The first parameter is in 4($fp), the next one in 8($fp) and so on. The
+       slots for let and case variables are pushed by the callee, the first
+       one is in -4($fp), the next one in -8($fp) and so on.
     */
 
-    std::map<ClassPtr, ClassPtr> inherit_graph; // inheritance graph created from semantic analysis stage
+    ConstantPool& constants; // constants of the program, the class names are added to it
+    const ClassTable& class_table; // classes and inheritance tree created from semantic analysis stage
+    const ClassLayout& class_layout; // dispatch table and attribute offsets of each class
     std::ostream& os; // code generation output
-
-    std::size_t curr_attr_count; // used to keep track of current attribute count for a specific class when
-                                 // generating code for class_init methods
+    ThreadPool* pool; // used to generate the classes, nullptr to do it on this thread
 
     Symbol curr_class; // current class where code is being generated for, used by dynamic dispatch
+    ClassTable::ClassId curr_class_id;
 
-    SymbolTable<Symbol, int> var_env; // the variable environment mapping that maps variable names
-                                      // to offsets in the current AR relative to the fp. this allows for easier
-                                      // addressing. eg. the first parameter is in 4($fp), next is 8($fp) ... n($fp)
-
-    std::map<Symbol, std::map<Symbol, int>> method_tbl; // contains mapping of [class name][method name] -> offset in dispatch table
-                                                        // used to implement dispatch
-
-    std::map<Symbol, std::map<Symbol, int>> attr_tbl; // table of class attributes used to determine valid names
-                                                      // that are in scope
-
-    std::size_t while_count; // running count of all while statements in the source file, used for label numbering
-                             // in the generated code
+    std::size_t while_count; // running count of the while statements in the current class, used for label numbering
+                             // in the generated code, the labels start with the class name
     std::size_t if_count;
 
     // The following emit_* functions are all helper functions to make emitting MIPS code easier
@@ -172,6 +180,11 @@ private:
     void emit_syscall();
     void emit_nop();
 
+    // load a variable into $a0 and store $a0 into a variable, using the
+    // binding the type checker resolved for the variable
+    void emit_load_var(const VarBinding&);
+    void emit_store_var(const VarBinding&);
+
     void emit_initial_data();
 
     // emit code for string and integer constants
@@ -181,21 +194,23 @@ private:
     //void code_prototype_table();
 
     // emit code for each object's dispatch table
-    void code_dispatch_table(const ClassPtr&);
+    void code_dispatch_table(ClassTable::ClassId);
+
+    // emit the code of the classes in class id order
+    void code_classes();
 
     // emit code for prototype objects
     void code_prototype_objects();
 
-    // calculates the size of an object, used when generating code
-    // for each object prototype
-    int calc_obj_size(const ClassPtr&);
-
     // emit code for the prototype object attributes
-    void emit_obj_attribs(const ClassPtr&);
+    void emit_obj_attribs(ClassTable::ClassId);
 
 public:
-    AstNodeCodeGenerator(const std::map<ClassPtr, ClassPtr>&,
-            std::ostream&);
+    AstNodeCodeGenerator(ConstantPool&, const ClassTable&, const ClassLayout&, std::ostream&, ThreadPool* = nullptr);
+
+    // emits the data section and starts the text section, which is what
+    // comes before the code of the classes. visit(Program&) does both
+    void code_data();
 
     void visit(Program&);
     void visit(Class&);
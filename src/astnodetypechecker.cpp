@@ -2,17 +2,31 @@
 #include "constants.hpp"
 #include "utility.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <sstream>
 
 using namespace constants;
 
-AstNodeTypeChecker::AstNodeTypeChecker(const std::map<ClassPtr, ClassPtr>& ig)
-    : inherit_graph(ig), err_count(0)
+AstNodeTypeChecker::AstNodeTypeChecker(const SourceManager& sm, const ClassTable& ct, const ClassLayout& cl)
+    : curr_class_id(ClassTable::NO_CLASS_ID), curr_locals(0), max_locals(0),
+      sources(sm), class_table(ct), class_layout(cl), err_count(0)
 {
 
 }
 
+VarBinding AstNodeTypeChecker::attribute_binding(const Symbol& name) const
+{
+    return VarBinding(VarBinding::ATTRIBUTE, class_layout.find_attr(curr_class_id, name));
+}
+
+VarBinding AstNodeTypeChecker::new_local()
+{
+    VarBinding binding(VarBinding::LOCAL, curr_locals++);
+    max_locals = std::max(max_locals, curr_locals);
+    return binding;
+}
+
 std::size_t AstNodeTypeChecker::get_err_count() const
 {
     return err_count;
@@ -20,7 +34,9 @@ std::size_t AstNodeTypeChecker::get_err_count() const
 
 void AstNodeTypeChecker::error(const AstNode& node, const std::string& msg)
 {
-    utility::print_error(node, msg);
+    std::ostringstream err;
+    utility::print_error(err, sources, node, msg);
+    diagnostics += err.str();
     ++err_count;
 }
 
@@ -33,107 +49,94 @@ bool AstNodeTypeChecker::is_subtype(const Symbol& child, const Symbol& parent)
     // for methods that return SELF_TYPE
     if (child == SELF_TYPE || parent == SELF_TYPE) return true;
 
-    // find @child's pointer to class
-    auto child_cptr = std::find_if(begin(inherit_graph), end(inherit_graph),
-            [&](const std::pair<ClassPtr, ClassPtr>& p) {
-                return p.first->name == child;
-            }); 
+    return class_table.is_subtype(child, parent);
+}
+
+Symbol AstNodeTypeChecker::lub(const std::vector<Symbol>& types)
+{
+    ClassTable::ClassId result = ClassTable::NO_CLASS_ID;
 
-    // this simply checks if parent is encountered anywhere in 
-    // child's inheritance tree
-    ClassPtr curr = child_cptr->first;
-    while(curr->name != OBJECT) 
+    for (auto& type : types)
     {
-        if (curr->name == parent)
-            return true;
+        // NoType and SELF_TYPE are treated as subtypes of everything by is_subtype
+        if (type == NOTYPE || type == SELF_TYPE)
+            continue;
+
+        ClassTable::ClassId id = class_table.find(type);
+        if (id == ClassTable::NO_CLASS_ID)
+            return OBJECT;
 
-        curr = inherit_graph[curr];
+        result = result == ClassTable::NO_CLASS_ID ? id : class_table.lca(result, id);
     }
 
-    return false;
+    return result == ClassTable::NO_CLASS_ID ? types.front() : class_table.get_class(result)->name;
 }
 
-Symbol AstNodeTypeChecker::lub(const std::vector<Symbol>& types)
+const Method* AstNodeTypeChecker::find_method(const Symbol& type, const Symbol& name) const
 {
-    Symbol base = types.front(); 
+    ClassTable::ClassId id = class_table.find(type);
+    if (id == ClassTable::NO_CLASS_ID)
+        return nullptr;
 
-    if (std::all_of(begin(types) + 1, end(types), std::bind2nd(std::equal_to<Symbol>(), base)))
-        return base;
+    int slot = class_layout.find_method(id, name);
+    return slot == ClassLayout::NO_SLOT ? nullptr : class_layout.get_method(id, slot).method;
+}
 
-    auto base_ptr = std::find_if(begin(inherit_graph), end(inherit_graph),
-            [&](const std::pair<ClassPtr, ClassPtr>& p) {
-                return p.first->name == base;
-            }); 
+bool AstNodeTypeChecker::args_match(const std::vector<Symbol>& types, const Method& method)
+{
+    return types.size() == method.params.size() &&
+        std::equal(begin(types), end(types), begin(method.params),
+            [&](const Symbol& t, const FormalPtr& f) {
+                return is_subtype(t, f->type_decl);
+            });
+}
 
-    ClassPtr curr = base_ptr->first;
+void AstNodeTypeChecker::check_overrides(const Class& cs)
+{
+    // an overriding method must have the same signature, including the return type,
+    // as the method it overrides. the method it overrides is the one that
+    // occupies the same slot in the parent's dispatch table
+    ClassTable::ClassId parent = class_table.get_parent(class_table.find(cs.name));
 
-    while (curr->parent != OBJECT)
+    if (parent == ClassTable::NO_CLASS_ID)
+        return;
+
+    for (auto& method : cs.methods)
     {
-        auto result = std::find_if(begin(types), end(types), 
-                [&](const Symbol& s) {
-                    return !is_subtype(s, curr->parent);
-                });
+        int slot = class_layout.find_method(parent, method->name);
 
-        if (result == end(types))
-            return curr->parent;
+        if (slot == ClassLayout::NO_SLOT)
+            continue;
 
-        curr = inherit_graph[curr];
-    }
+        const ClassLayout::MethodSlot& overriden = class_layout.get_method(parent, slot);
+        const Symbol& base = class_table.get_class(overriden.owner)->name;
 
-    return OBJECT;
+        if (method->params.size() != overriden.method->params.size() ||
+                !std::equal(begin(method->params), end(method->params), begin(overriden.method->params),
+                        [](const FormalPtr& f1, const FormalPtr& f2) {
+                            return f1->type_decl == f2->type_decl;
+                        }))
+        {
+            std::ostringstream oss;
+            oss << "overriden method " << base << "." << method->name 
+                << " has different parameters from " << cs.name << "." << method->name;   
+            error(*method, oss.str());
+        }
+
+        if (method->return_type != overriden.method->return_type)
+        {
+            std::ostringstream oss;
+            oss << "overriden method " << base << "." << method->name
+                << " has different return type from " << cs.name << "." << method->name;
+            error(*method, oss.str());
+        }
+    }
 }
 
 void AstNodeTypeChecker::visit(Program& prog)
 {
-    // populate method table with [class][method] -> argument types, return type
     for (auto& cs : prog.classes)
-    {
-        Symbol cl = cs->name;
-        ClassPtr curr = cs;
-
-        while (curr->name != NOCLASS)
-        {
-            for (auto& method : curr->methods)
-            {
-                // if an overriden method already exists, don't add anymore
-                if (mtbl[cl].find(method->name) == end(mtbl[cl]))
-                {
-                    for (auto& formal : method->params) 
-                        mtbl[cl][method->name].push_back(formal->type_decl);
-
-                    mtbl[cl][method->name].push_back(method->return_type);
-                }
-                else
-                {
-                    // if there is an overriden version of this method, type check
-                    // to ensure that the signature including return type is exactly same 
-                    
-                    // have to subtract 1 from mtbl because the last element is the return type (ie. it has one extra element)
-                    if (method->params.size() != mtbl[cl][method->name].size() - 1 || 
-                            !std::equal(begin(method->params), end(method->params), begin(mtbl[cl][method->name]), 
-                                    [](const FormalPtr& f, const Symbol& s) {
-                                        return f->type_decl == s; 
-                                    }))
-                    {
-                        std::ostringstream oss;
-                        oss << "overriden method " << curr->name << "." << method->name 
-                            << " has different parameters from " << cl << "." << method->name;   
-                        error(*method, oss.str());
-                    }
-
-                    if (method->return_type != mtbl[cl][method->name].back())
-                    {
-                        std::ostringstream oss;
-                        oss << "overriden method " << curr->name << "." << method->name
-                            << " has different return type from " << cl << "." << method->name << "\n";
-                        error(*method, oss.str());
-                    }
-                }
-            }
-
-            curr = inherit_graph[curr];
-        }
-    }
+        check_overrides(*cs);
 
     for (auto& cs : prog.classes)
         cs->accept(*this);
@@ -143,34 +146,28 @@ void AstNodeTypeChecker::visit(Class& cs)
 {
     env.enter_scope();
     curr_class = cs.name;
-    env.add(SELF, curr_class);
-
-    auto cs_ptr = std::find_if(begin(inherit_graph), end(inherit_graph),
-            [&](const std::pair<ClassPtr, ClassPtr>& p) {
-                return cs.parent == p.first->name;
-            });
+    curr_class_id = class_table.find(cs.name);
+    env.add(SELF, Variable { curr_class, VarBinding(VarBinding::SELF_OBJECT) });
 
-    if (cs_ptr != end(inherit_graph))
+    for (auto id = class_table.find(cs.parent); id != ClassTable::NO_CLASS_ID; id = class_table.get_parent(id))
     {
-        ClassPtr cptr = cs_ptr->first;
-
-        while (cptr->name != NOCLASS)
+        for (auto& attrib : class_table.get_class(id)->attributes)
         {
-            for (auto& attrib : cptr->attributes)
-            {
-                if (env.probe(attrib->name))
-                    error(*attrib, "attribute " + attrib->name.get_val() + " redefined in one of its subclasses");
-                else
-                    env.add(attrib->name, attrib->type_decl);
-            }
-
-            cptr = inherit_graph[cptr];
+            if (env.probe(attrib->name))
+                error(*attrib, "attribute " + attrib->name.get_val() + " redefined in one of its subclasses");
+            else
+                env.add(attrib->name, Variable { attrib->type_decl, attribute_binding(attrib->name) });
         }
     }
 
+    // the attribute initializers all run in the AR of the class' _init method
+    curr_locals = max_locals = 0;
+
     for (auto& attrib : cs.attributes)
         attrib->accept(*this);
 
+    cs.num_init_locals = max_locals;
+
     for (auto& method : cs.methods)
         method->accept(*this);
 
@@ -179,7 +176,7 @@ void AstNodeTypeChecker::visit(Class& cs)
 
 void AstNodeTypeChecker::visit(Attribute& attr)
 {
-    env.add(attr.name, attr.type_decl);
+    env.add(attr.name, Variable { attr.type_decl, attribute_binding(attr.name) });
     attr.init->accept(*this);
 
     if (attr.init->type != NOTYPE)
@@ -189,12 +186,19 @@ void AstNodeTypeChecker::visit(Attribute& attr)
 
 void AstNodeTypeChecker::visit(Method& method)
 {
+    // a body the parser skipped is only parsed if the method can be
+    // called, see lazymethods.hpp
+    if (!method.body)
+        return;
+
     env.enter_scope();
+    curr_locals = max_locals = 0;
 
-    for (auto& formals : method.params)
-        env.add(formals->name, formals->type_decl);
+    for (std::size_t i = 0; i < method.params.size(); ++i)
+        env.add(method.params[i]->name, Variable { method.params[i]->type_decl, VarBinding(VarBinding::FORMAL, i) });
 
     method.body->accept(*this);
+    method.num_locals = max_locals;
 
     if (!is_subtype(method.body->type, method.return_type))
         error(method, "method body type not a subtype of return type");
@@ -247,17 +251,19 @@ void AstNodeTypeChecker::visit(CaseBranch& br)
 
 void AstNodeTypeChecker::visit(Assign& assign)
 {
-    boost::optional<Symbol> obj_type = env.lookup(assign.name);
+    boost::optional<Variable> var = env.lookup(assign.name);
     assign.type = OBJECT;
 
-    if (!obj_type)
+    if (var)
+        assign.binding = var->binding;
+    else
         error(assign, "variable " + assign.name.get_val() + " not in scope");
 
     assign.rhs->accept(*this);
 
-    if (is_subtype(assign.rhs->type, *obj_type))
+    if (!var || is_subtype(assign.rhs->type, var->type))
     {
-        if (obj_type)
+        if (var)
             assign.type = assign.rhs->type;
     }
     else
@@ -443,16 +449,20 @@ void AstNodeTypeChecker::visit(StaticDispatch& stat)
         stat.type = OBJECT;
     }
 
-    // check if each dispatch argument's type is a subtype of declared type for method
-    bool result = std::equal(begin(disptypes), end(disptypes), begin(mtbl[stat.type_decl][stat.method]),
-            [&](const Symbol& t1, const Symbol& t2) {
-                return is_subtype(t1, t2);
-            });
+    const Method* method = find_method(stat.type_decl, stat.method);
 
-    if (result)
+    if (!method)
+    {
+        error(stat, "method " + stat.method.get_val() + " is not defined in class " + stat.type_decl.get_val());
+        stat.type = OBJECT;
+        return;
+    }
+
+    // check if each dispatch argument's type is a subtype of declared type for method
+    if (args_match(disptypes, *method))
     {
         if (statsub)
-            stat.type = mtbl[stat.type_decl][stat.method].back();
+            stat.type = method->return_type;
     }
     else
     {
@@ -479,7 +489,9 @@ void AstNodeTypeChecker::visit(DynamicDispatch& dyn)
     if (obj_type == curr_class)
         obj_type = curr_class;
 
-    if (mtbl[obj_type].find(dyn.method) == end(mtbl[obj_type]))
+    const Method* method = find_method(obj_type, dyn.method);
+
+    if (!method)
     {
         error(dyn, "method " + dyn.method.get_val() + " is not defined in this class");
         dyn.type = OBJECT;
@@ -487,14 +499,9 @@ void AstNodeTypeChecker::visit(DynamicDispatch& dyn)
     }
 
     // check if each dispatch argument's type is a subtype of declared type for method
-    bool result = std::equal(begin(disptypes), end(disptypes), begin(mtbl[obj_type][dyn.method]),
-            [&](const Symbol& t1, const Symbol& t2) {
-                return is_subtype(t1, t2);
-            });
-
-    if (result)
+    if (args_match(disptypes, *method))
     {
-        dyn.type = mtbl[obj_type][dyn.method].back();
+        dyn.type = method->return_type;
     }
     else
     {
@@ -518,12 +525,14 @@ void AstNodeTypeChecker::visit(Let& let)
     }
 
     env.enter_scope();
-    env.add(let.name, let.type_decl);
+    let.binding = new_local();
+    env.add(let.name, Variable { let.type_decl, let.binding });
     let.body->accept(*this);
 
     if (type_status)
         let.type = let.body->type;
 
+    --curr_locals;
     env.exit_scope();
 }
 
@@ -536,9 +545,11 @@ void AstNodeTypeChecker::visit(Case& cs)
     for (auto& br : cs.branches)
     {
         env.enter_scope();
-        env.add(br->name, br->type_decl);
+        br->binding = new_local();
+        env.add(br->name, Variable { br->type_decl, br->binding });
         br->accept(*this);
         types.push_back(br->type);
+        --curr_locals;
         env.exit_scope();
     }
 
@@ -547,11 +558,14 @@ void AstNodeTypeChecker::visit(Case& cs)
 
 void AstNodeTypeChecker::visit(Object& var)
 {
-    boost::optional<Symbol> obj_type = env.lookup(var.name);
+    boost::optional<Variable> obj = env.lookup(var.name);
     var.type = OBJECT;
 
-    if (obj_type)
-        var.type = *obj_type;
+    if (obj)
+    {
+        var.type = obj->type;
+        var.binding = obj->binding;
+    }
     else
         error(var, "variable " + var.name.get_val() + " not in scope");
 }
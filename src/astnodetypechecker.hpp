@@ -2,35 +2,71 @@
 // Currently, the type checker handles errors by assigning a type of Object
 // to the node that didn't type check properly. This will cause the errors
 // to propagate if a type error is found 
+// A class is checked without writing to anything but its own nodes, so
+// several checkers can work on different classes of a program at the same
+// time. Errors are collected rather than printed for that reason.
 
 #ifndef ASTNODETYPECHECKER_H
 #define ASTNODETYPECHECKER_H
 
 #include "astnodevisitor.hpp"
+#include "classtable.hpp"
+#include "classlayout.hpp"
 
-typedef std::map<Symbol, std::map<Symbol, std::vector<Symbol>>> MethodTypeTable;
+#include <string>
 
 class AstNodeTypeChecker : public AstNodeVisitor
 {
 private:
-    SymbolTable<Symbol, Symbol> env; // used to verify scoping rules
+    // type and runtime location of a variable in scope
+    struct Variable
+    {
+        Symbol type;
+        VarBinding binding;
+    };
+
+    SymbolTable<Symbol, Variable> env; // used to verify scoping rules
     Symbol curr_class; // current class that's being type checked
-    MethodTypeTable mtbl; // mapping of [class name][method name] -> param_type0 ... param_typeN, return type
-    std::map<ClassPtr, ClassPtr> inherit_graph; // inheritance tree
+    ClassTable::ClassId curr_class_id;
+
+    std::size_t curr_locals; // number of let and case variables in scope in the current method
+    std::size_t max_locals; // most let and case variables in scope at once in the current method
+    const SourceManager& sources; // files of the compilation, to name them in errors
+    const ClassTable& class_table; // all classes and the inheritance tree
+    const ClassLayout& class_layout; // dispatch tables, used to look up method signatures
 
     std::size_t err_count; // total number of errors encountered 
 
     // check if a type is a subtype of the other type
     bool is_subtype(const Symbol&, const Symbol&);
 
+    // method that is called when dispatching to an object of the given type,
+    // nullptr if the type doesn't have the method
+    const Method* find_method(const Symbol&, const Symbol&) const;
+
+    // check if the types of the arguments of a dispatch match the method's parameters
+    bool args_match(const std::vector<Symbol>&, const Method&);
+
     // least upper bound of a list of types in the inheritance tree
     Symbol lub(const std::vector<Symbol>&);
 
+    // binding of an attribute of the current class
+    VarBinding attribute_binding(const Symbol&) const;
+
+    // binding for a new let or case variable, which takes the next free AR slot
+    VarBinding new_local();
+
     // wrapper for generic error functions in utility.hpp
     void error(const AstNode&, const std::string&);
 
 public:
-    AstNodeTypeChecker(const std::map<ClassPtr, ClassPtr>&);
+    std::string diagnostics; // the errors found so far, in the order they were found
+
+    AstNodeTypeChecker(const SourceManager&, const ClassTable&, const ClassLayout&);
+
+    // checks that the methods of a class that override a method have its signature
+    void check_overrides(const Class&);
+
     void visit(Program&);
     void visit(Class&);
     void visit(Attribute&);
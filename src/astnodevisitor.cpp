@@ -5,12 +5,18 @@
 #include <memory>
 #include <iomanip>
 
-AstNodeDisplayer::AstNodeDisplayer(std::ostream& stream, display_option option)
-    : os(stream), depth(0), opt(option)
+AstNodeDisplayer::AstNodeDisplayer(std::ostream& stream, display_option option, const SourceManager* lines)
+    : os(stream), depth(0), opt(option), sources(lines)
 {
 
 }
 
+void AstNodeDisplayer::show_line(const AstNode& node)
+{
+    if (sources)
+        os << "#" << sources->get_line(node.loc) << " ";
+}
+
 void AstNodeDisplayer::visit(Program& prog)
 {
     for (auto& cs : prog.classes)
@@ -37,6 +43,7 @@ void AstNodeDisplayer::visit(Class& cs)
     // the * 2 is just an arbitrary multiplier to make
     // the indentation look nicer
     os << std::setw(depth++ * 2) << "";
+    show_line(cs);
     os << "_class (" << cs.name << ")\n";  
     
     for (auto& attrib : cs.attributes)
@@ -51,6 +58,7 @@ void AstNodeDisplayer::visit(Class& cs)
 void AstNodeDisplayer::visit(Attribute& attr)
 {
     os << std::setw(depth++ * 2) << "";
+    show_line(attr);
     os << "_attribute (" << attr.name << ")\n";
     attr.init->accept(*this);
     --depth;
@@ -59,48 +67,56 @@ void AstNodeDisplayer::visit(Attribute& attr)
 void AstNodeDisplayer::visit(Formal& formal) 
 { 
     os << std::setw(depth * 2) << "";
+    show_line(formal);
     os << "_formal (" << formal.name << ")\n";
 }
 
 void AstNodeDisplayer::visit(Method& method) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(method);
     os << "_method (" << method.name << ")\n";
 
     for (auto& formal : method.params)
         formal->accept(*this); 
 
-    method.body->accept(*this);
+    if (method.body)
+        method.body->accept(*this);
     --depth;
 }
 
 void AstNodeDisplayer::visit(StringConst& str) 
 { 
     os << std::setw(depth * 2) << "";
+    show_line(str);
     os << "_stringconst(" << str.token << ") : " << str.type << "\n";
 }
 
 void AstNodeDisplayer::visit(IntConst& int_const) 
 {
     os << std::setw(depth * 2) << "";
+    show_line(int_const);
     os << "_intconst(" << int_const.token << ") : " << int_const.type << "\n";
 }
 
 void AstNodeDisplayer::visit(BoolConst& bool_const) 
 { 
     os << std::setw(depth * 2) << "";
+    show_line(bool_const);
     os << "_boolconst(" << bool_const.value << ") : " << bool_const.type << "\n";
 }
 
 void AstNodeDisplayer::visit(New& new_node) 
 {
     os << std::setw(depth * 2) << "";
+    show_line(new_node);
     os << "_new (" << new_node.type_decl << ") : " << new_node.type << "\n";
 }
 
 void AstNodeDisplayer::visit(IsVoid& isvoid) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(isvoid);
     os << "_isvoid : " << isvoid.type << "\n";
     isvoid.expr->accept(*this); 
     --depth;
@@ -109,6 +125,7 @@ void AstNodeDisplayer::visit(IsVoid& isvoid)
 void AstNodeDisplayer::visit(CaseBranch& branch) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(branch);
     os << "_casebranch (" << branch.name << ") : " << branch.type << "\n";
     branch.expr->accept(*this);
     --depth;
@@ -117,6 +134,7 @@ void AstNodeDisplayer::visit(CaseBranch& branch)
 void AstNodeDisplayer::visit(Assign& assign) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(assign);
     os << "_assign (" << assign.name << ") : " << assign.type << "\n";
     assign.rhs->accept(*this);
     --depth;
@@ -125,6 +143,7 @@ void AstNodeDisplayer::visit(Assign& assign)
 void AstNodeDisplayer::visit(Block& block) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(block);
     os << "_block : " << block.type << "\n";
 
     for (auto& expr : block.body)
@@ -135,6 +154,7 @@ void AstNodeDisplayer::visit(Block& block)
 void AstNodeDisplayer::visit(If& ifstmt) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(ifstmt);
     os << "_if : " << ifstmt.type << "\n";
 
     ifstmt.predicate->accept(*this);
@@ -146,6 +166,7 @@ void AstNodeDisplayer::visit(If& ifstmt)
 void AstNodeDisplayer::visit(While& whilestmt) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(whilestmt);
     os << "_while : " << whilestmt.type << "\n";
 
     whilestmt.predicate->accept(*this);
@@ -156,6 +177,7 @@ void AstNodeDisplayer::visit(While& whilestmt)
 void AstNodeDisplayer::visit(Complement& comp) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(comp);
     os << "_complement : " << comp.type << "\n";
     comp.expr->accept(*this);
     --depth;
@@ -164,6 +186,7 @@ void AstNodeDisplayer::visit(Complement& comp)
 void AstNodeDisplayer::visit(LessThan& lt) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(lt);
     os << "_lessthan : " << lt.type << "\n";
     lt.lhs->accept(*this);
     lt.rhs->accept(*this);
@@ -173,6 +196,7 @@ void AstNodeDisplayer::visit(LessThan& lt)
 void AstNodeDisplayer::visit(EqualTo& eq) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(eq);
     os << "_equalto : " << eq.type << "\n";
     eq.lhs->accept(*this);
     eq.rhs->accept(*this);
@@ -182,6 +206,7 @@ void AstNodeDisplayer::visit(EqualTo& eq)
 void AstNodeDisplayer::visit(LessThanEqualTo& lteq) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(lteq);
     os << "_lessthanequalto : " << lteq.type << "\n";
     lteq.lhs->accept(*this);
     lteq.rhs->accept(*this);
@@ -191,6 +216,7 @@ void AstNodeDisplayer::visit(LessThanEqualTo& lteq)
 void AstNodeDisplayer::visit(Plus& plus) 
 {
     os << std::setw(depth++ * 2) << "";
+    show_line(plus);
     os << "_plus : " << plus.type << "\n";
     plus.lhs->accept(*this);
     plus.rhs->accept(*this);
@@ -200,6 +226,7 @@ void AstNodeDisplayer::visit(Plus& plus)
 void AstNodeDisplayer::visit(Sub& sub) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(sub);
     os << "_sub : " << sub.type << "\n";
     sub.lhs->accept(*this);
     sub.rhs->accept(*this);
@@ -209,6 +236,7 @@ void AstNodeDisplayer::visit(Sub& sub)
 void AstNodeDisplayer::visit(Mul& mul) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(mul);
     os << "_mul : " << mul.type << "\n";
     mul.lhs->accept(*this);
     mul.rhs->accept(*this);
@@ -218,6 +246,7 @@ void AstNodeDisplayer::visit(Mul& mul)
 void AstNodeDisplayer::visit(Div& div) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(div);
     os << "_div : " << div.type << "\n";
     div.lhs->accept(*this);
     div.rhs->accept(*this);
@@ -227,6 +256,7 @@ void AstNodeDisplayer::visit(Div& div)
 void AstNodeDisplayer::visit(Not& nt) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(nt);
     os << "_not : " << nt.type << "\n";
     nt.expr->accept(*this);
     --depth;
@@ -235,6 +265,7 @@ void AstNodeDisplayer::visit(Not& nt)
 void AstNodeDisplayer::visit(StaticDispatch& sdisp) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(sdisp);
     os << "_staticdispatch (" << sdisp.method << ") : " << sdisp.type << "\n";
 
     sdisp.obj->accept(*this);
@@ -246,6 +277,7 @@ void AstNodeDisplayer::visit(StaticDispatch& sdisp)
 void AstNodeDisplayer::visit(DynamicDispatch& ddisp) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(ddisp);
     os << "_dynamicdispatch (" << ddisp.method << ") : " << ddisp.type << "\n";
 
     ddisp.obj->accept(*this);
@@ -257,6 +289,7 @@ void AstNodeDisplayer::visit(DynamicDispatch& ddisp)
 void AstNodeDisplayer::visit(Let& let) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(let);
     os << "_let (" << let.name << ") : " << let.type << "\n";
     
     let.init->accept(*this);
@@ -267,6 +300,7 @@ void AstNodeDisplayer::visit(Let& let)
 void AstNodeDisplayer::visit(Case& caze) 
 { 
     os << std::setw(depth++ * 2) << "";
+    show_line(caze);
     os << "_case : " << caze.type << "\n";
 
     caze.expr->accept(*this);
@@ -278,11 +312,13 @@ void AstNodeDisplayer::visit(Case& caze)
 void AstNodeDisplayer::visit(Object& obj) 
 { 
     os << std::setw(depth * 2) << "";
+    show_line(obj);
     os << "_object (" << obj.name << ") : " << obj.type << "\n";
 }
 
 void AstNodeDisplayer::visit(NoExpr& ne) 
 { 
     os << std::setw(depth * 2) << "";
+    show_line(ne);
     os << "_noexpr : " << ne.type << "\n";
 }
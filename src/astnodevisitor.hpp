@@ -2,12 +2,14 @@
 #define ASTNODEVISITOR_H
 
 #include "ast.hpp"
+#include "sourcemanager.hpp"
 #include "tokentable.hpp"
 #include <iostream>
 
 // Forward declarations since there are 
 // circular dependencies of the ast node classes
 // and the visitors
+class AstNode;
 class Program;
 class Class;
 class Attribute;
@@ -85,7 +87,8 @@ public:
         DISPLAYNONBASIC
     };
 
-    AstNodeDisplayer(std::ostream&, display_option = DISPLAYALL);
+    // given the sources of the nodes, every node is prefixed with the line it's on
+    AstNodeDisplayer(std::ostream&, display_option = DISPLAYALL, const SourceManager* lines = nullptr);
 
     void visit(Program&);
     void visit(Class&);
@@ -122,6 +125,9 @@ private:
     std::ostream& os; 
     size_t depth; //Used to keep track of the AST depth of the visitor for proper indentation
     display_option opt;
+    const SourceManager* sources; // to look up the lines of the nodes, if they are shown
+
+    void show_line(const AstNode&);
 };
 
 #endif
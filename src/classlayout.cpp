@@ -0,0 +1,97 @@
+#include "classlayout.hpp"
+#include "prelude.hpp"
+
+#include <cassert>
+
+const int ClassLayout::NO_SLOT;
+
+int ClassLayout::find_slot(const std::unordered_map<std::uint64_t, int>& slots,
+        ClassTable::ClassId id, const Symbol& name)
+{
+    auto it = slots.find(key(id, name));
+    return it == end(slots) ? NO_SLOT : it->second;
+}
+
+const ClassLayout& ClassLayout::prelude()
+{
+    static const ClassLayout layout = []
+    {
+        ClassLayout basic;
+        basic.method_begin.assign(prelude::CLASS_COUNT, 0);
+        basic.method_counts.assign(prelude::CLASS_COUNT, 0);
+        basic.attr_begin.assign(prelude::CLASS_COUNT, 0);
+        basic.attr_counts.assign(prelude::CLASS_COUNT, 0);
+
+        // the basic classes come after their parents
+        for (int id = 0; id < prelude::CLASS_COUNT; ++id)
+        {
+            basic.add(id, prelude::classes()[id], prelude::CLASSES[id].parent_id);
+            assert(basic.method_counts[id] == prelude::method_count(id));
+            assert(basic.attr_counts[id] == prelude::attr_count(id));
+        }
+
+        return basic;
+    }();
+
+    return layout;
+}
+
+void ClassLayout::build(const ClassTable& class_table)
+{
+    *this = prelude();
+
+    method_begin.resize(class_table.size(), 0);
+    method_counts.resize(class_table.size(), 0);
+    attr_begin.resize(class_table.size(), 0);
+    attr_counts.resize(class_table.size(), 0);
+
+    for (auto id : class_table.get_preorder())
+    {
+        if (id >= prelude::CLASS_COUNT)
+            add(id, class_table.get_class(id), class_table.get_parent(id));
+    }
+}
+
+void ClassLayout::add(ClassTable::ClassId id, const ClassPtr& class_node, ClassTable::ClassId parent)
+{
+    method_begin[id] = methods.size();
+    attr_begin[id] = attrs.size();
+
+    // start off with a copy of the parent's layout
+    if (parent != ClassTable::NO_CLASS_ID)
+    {
+        for (std::size_t slot = 0; slot < method_counts[parent]; ++slot)
+        {
+            MethodSlot inherited = get_method(parent, slot);
+            method_slots[key(id, inherited.method->name)] = slot;
+            methods.push_back(inherited);
+        }
+
+        for (std::size_t slot = 0; slot < attr_counts[parent]; ++slot)
+        {
+            AttributePtr inherited = get_attr(parent, slot);
+            attr_slots[key(id, inherited->name)] = slot;
+            attrs.push_back(inherited);
+        }
+    }
+
+    for (auto& method : class_node->methods)
+    {
+        auto result = method_slots.insert(std::make_pair(key(id, method->name), methods.size() - method_begin[id]));
+
+        // an overriding method takes over the slot of the method it overrides
+        if (result.second)
+            methods.push_back(MethodSlot { id, method });
+        else
+            methods[method_begin[id] + result.first->second] = MethodSlot { id, method };
+    }
+
+    for (auto& attrib : class_node->attributes)
+    {
+        attr_slots[key(id, attrib->name)] = attrs.size() - attr_begin[id];
+        attrs.push_back(attrib);
+    }
+
+    method_counts[id] = methods.size() - method_begin[id];
+    attr_counts[id] = attrs.size() - attr_begin[id];
+}
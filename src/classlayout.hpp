@@ -0,0 +1,99 @@
+// Object and dispatch table layout of every class.
+// The layout of a class is its parent's layout with the class' own attributes
+// appended, and its own methods either replacing the parent's method of the same
+// name or appended to the dispatch table. Classes are laid out parents first, so
+// each layout is built from the already computed layout of the parent and the
+// whole pass is linear in the size of the program. The layout of the basic
+// classes is the same for every program, it's only built once and every
+// layout starts out as a copy of it.
+
+#ifndef CLASSLAYOUT_H
+#define CLASSLAYOUT_H
+
+#include "classtable.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class ClassLayout
+{
+public:
+    // an entry of a dispatch table
+    struct MethodSlot
+    {
+        ClassTable::ClassId owner; // class whose implementation is dispatched to
+        MethodPtr method;
+    };
+
+    static const int NO_SLOT = -1;
+
+private:
+    // The layouts of all classes are stored back to back. [class id] -> index
+    // of the class' first slot in the flat arrays
+    std::vector<std::size_t> method_begin;
+    std::vector<std::size_t> method_counts;
+    std::vector<MethodSlot> methods;
+
+    std::vector<std::size_t> attr_begin;
+    std::vector<std::size_t> attr_counts;
+    std::vector<AttributePtr> attrs;
+
+    // (class id, name) -> slot index, for every method and attribute visible in a class
+    std::unordered_map<std::uint64_t, int> method_slots;
+    std::unordered_map<std::uint64_t, int> attr_slots;
+
+    static std::uint64_t key(ClassTable::ClassId id, const Symbol& name)
+    {
+        return static_cast<std::uint64_t>(id) << 32 | name.get_id();
+    }
+
+    static int find_slot(const std::unordered_map<std::uint64_t, int>&, ClassTable::ClassId, const Symbol&);
+
+    // layout of the basic classes alone
+    static const ClassLayout& prelude();
+
+    // lays out a class after its parent, NO_CLASS_ID for Object
+    void add(ClassTable::ClassId, const ClassPtr&, ClassTable::ClassId parent);
+
+public:
+    // the class table must have been indexed
+    void build(const ClassTable&);
+
+    // number of entries in the class' dispatch table
+    std::size_t method_count(ClassTable::ClassId id) const
+    {
+        return method_counts[id];
+    }
+
+    const MethodSlot& get_method(ClassTable::ClassId id, std::size_t slot) const
+    {
+        return methods[method_begin[id] + slot];
+    }
+
+    // dispatch table offset of a method, NO_SLOT if the class has no such method
+    int find_method(ClassTable::ClassId id, const Symbol& name) const
+    {
+        return find_slot(method_slots, id, name);
+    }
+
+    // number of attributes of the class, including the inherited ones
+    std::size_t attr_count(ClassTable::ClassId id) const
+    {
+        return attr_counts[id];
+    }
+
+    const AttributePtr& get_attr(ClassTable::ClassId id, std::size_t slot) const
+    {
+        return attrs[attr_begin[id] + slot];
+    }
+
+    // index of an attribute among the attributes of the object, NO_SLOT if the
+    // class has no such attribute
+    int find_attr(ClassTable::ClassId id, const Symbol& name) const
+    {
+        return find_slot(attr_slots, id, name);
+    }
+};
+
+#endif
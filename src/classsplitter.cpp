@@ -0,0 +1,135 @@
+#include "classsplitter.hpp"
+
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+    bool is_ident_char(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    bool is_class_keyword(const char* word, std::size_t len)
+    {
+        static const char keyword[] = "class";
+
+        if (len != sizeof(keyword) - 1)
+            return false;
+
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            if (std::tolower(static_cast<unsigned char>(word[i])) != keyword[i])
+                return false;
+        }
+
+        return true;
+    }
+}
+
+std::vector<ClassStart> find_class_starts(const char* src, std::size_t len)
+{
+    std::vector<ClassStart> starts;
+    const char* cur = src;
+    const char* end = src + len;
+    int line = 1;
+    int braces = 0; // number of braces open
+
+    while (cur < end)
+    {
+        char c = *cur;
+
+        if (c == '\n')
+        {
+            ++line;
+            ++cur;
+        }
+        else if (c == '(' && cur + 1 < end && cur[1] == '*')
+        {
+            // comments nest, a comment left open runs to the end
+            int depth = 1;
+            cur += 2;
+
+            while (cur < end && depth > 0)
+            {
+                if (*cur == '(' && cur + 1 < end && cur[1] == '*')
+                {
+                    ++depth;
+                    cur += 2;
+                }
+                else if (*cur == '*' && cur + 1 < end && cur[1] == ')')
+                {
+                    --depth;
+                    cur += 2;
+                }
+                else
+                {
+                    if (*cur == '\n')
+                        ++line;
+                    ++cur;
+                }
+            }
+        }
+        else if (c == '-' && cur + 1 < end && cur[1] == '-')
+        {
+            const char* nl = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+            cur = nl ? nl : end;
+        }
+        else if (c == '"')
+        {
+            // a string ends at the closing quote or, unterminated, at the
+            // end of the line. Escaped characters, newlines included, are
+            // part of the string
+            ++cur;
+
+            while (cur < end && *cur != '"' && *cur != '\n')
+            {
+                if (*cur == '\\' && cur + 1 < end)
+                {
+                    if (cur[1] == '\n')
+                        ++line;
+                    ++cur;
+                }
+                ++cur;
+            }
+
+            if (cur < end && *cur == '"')
+                ++cur;
+        }
+        else if (c == '{')
+        {
+            ++braces;
+            ++cur;
+        }
+        else if (c == '}')
+        {
+            // a stray closing brace is a syntax error, don't let it hide
+            // the classes that follow
+            if (braces > 0)
+                --braces;
+            ++cur;
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)))
+        {
+            const char* word = cur;
+            while (cur < end && is_ident_char(*cur))
+                ++cur;
+
+            if (braces == 0 && is_class_keyword(word, cur - word))
+                starts.push_back(ClassStart { static_cast<std::size_t>(word - src), line });
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)))
+        {
+            // an integer constant ends at the first non digit, even if a
+            // word follows right after
+            while (cur < end && std::isdigit(static_cast<unsigned char>(*cur)))
+                ++cur;
+        }
+        else
+        {
+            ++cur;
+        }
+    }
+
+    return starts;
+}
@@ -0,0 +1,25 @@
+// Finds where the top level classes of a source start, without parsing it.
+// A large file can then be cut at class boundaries and the pieces parsed at
+// the same time. The scan skips comments, nested or not, and string
+// constants the same way the lexers do, so a "class" inside them is never
+// taken for the start of a class. On a source with lexical or syntax errors
+// the boundaries may be wrong; parsing the pieces then fails and the file has
+// to be parsed as a whole instead.
+
+#ifndef CLASSSPLITTER_H
+#define CLASSSPLITTER_H
+
+#include <cstddef>
+#include <vector>
+
+class ClassStart
+{
+public:
+    std::size_t offset; // of the class keyword
+    int line; // line the class keyword is on
+};
+
+// Returns the start of every class keyword outside of braces, in source order
+std::vector<ClassStart> find_class_starts(const char*, std::size_t);
+
+#endif
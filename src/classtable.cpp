@@ -0,0 +1,141 @@
+#include "classtable.hpp"
+#include "prelude.hpp"
+
+#include <stack>
+#include <utility>
+
+const ClassTable::ClassId ClassTable::NO_CLASS_ID;
+
+ClassTable::ClassTable()
+{
+    for (auto& class_node : prelude::classes())
+        add(class_node);
+
+    for (ClassId id = 0; id < prelude::CLASS_COUNT; ++id)
+        parents[id] = prelude::CLASSES[id].parent_id;
+}
+
+ClassTable::ClassId ClassTable::add(const ClassPtr& class_node)
+{
+    if (ids.count(class_node->name) > 0)
+        return NO_CLASS_ID;
+
+    ClassId id = classes.size();
+    ids[class_node->name] = id;
+    classes.push_back(class_node);
+    parents.push_back(NO_CLASS_ID);
+    return id;
+}
+
+void ClassTable::build_index()
+{
+    std::vector<std::vector<ClassId>> children(classes.size());
+    std::vector<ClassId> roots;
+
+    for (std::size_t id = 0; id < classes.size(); ++id)
+    {
+        if (parents[id] == NO_CLASS_ID)
+            roots.push_back(id);
+        else
+            children[parents[id]].push_back(id);
+    }
+
+    pre.assign(classes.size(), 0);
+    post.assign(classes.size(), 0);
+    depth.assign(classes.size(), 0);
+    first.assign(classes.size(), 0);
+    preorder.clear();
+    preorder.reserve(classes.size());
+    euler.clear();
+    euler.reserve(2 * classes.size());
+
+    // the DFS is iterative since inheritance chains can be
+    // deeper than what the call stack can hold
+    int counter = 0;
+    std::stack<std::pair<ClassId, std::size_t>> dfs; // class, index of next child to visit
+
+    // after validation Object is the only root, so the tour covers a single tree
+    for (ClassId root : roots)
+    {
+        pre[root] = counter++;
+        preorder.push_back(root);
+        first[root] = euler.size();
+        euler.push_back(root);
+        dfs.push(std::make_pair(root, 0));
+
+        while (!dfs.empty())
+        {
+            auto& top = dfs.top();
+
+            if (top.second < children[top.first].size())
+            {
+                ClassId child = children[top.first][top.second++];
+                pre[child] = counter++;
+                preorder.push_back(child);
+                depth[child] = depth[top.first] + 1;
+                first[child] = euler.size();
+                euler.push_back(child);
+                dfs.push(std::make_pair(child, 0));
+            }
+            else
+            {
+                post[top.first] = counter++;
+                dfs.pop();
+
+                // back in the parent after finishing one of its subtrees
+                if (!dfs.empty())
+                    euler.push_back(dfs.top().first);
+            }
+        }
+    }
+
+    build_sparse_table();
+}
+
+void ClassTable::build_sparse_table()
+{
+    sparse.clear();
+    floor_log.assign(euler.size() + 1, 0);
+
+    for (std::size_t n = 2; n <= euler.size(); ++n)
+        floor_log[n] = floor_log[n / 2] + 1;
+
+    if (euler.empty())
+        return;
+
+    sparse.push_back(euler);
+
+    for (std::size_t len = 2; len <= euler.size(); len *= 2)
+    {
+        const std::vector<ClassId>& prev = sparse.back();
+        std::vector<ClassId> level(euler.size() - len + 1);
+
+        for (std::size_t i = 0; i < level.size(); ++i)
+            level[i] = shallower(prev[i], prev[i + len / 2]);
+
+        sparse.push_back(std::move(level));
+    }
+}
+
+bool ClassTable::is_subtype(const Symbol& child, const Symbol& parent) const
+{
+    ClassId child_id = find(child);
+    ClassId parent_id = find(parent);
+
+    return child_id != NO_CLASS_ID && parent_id != NO_CLASS_ID &&
+        is_subtype(child_id, parent_id);
+}
+
+ClassTable::ClassId ClassTable::lca(ClassId c1, ClassId c2) const
+{
+    std::size_t lo = first[c1];
+    std::size_t hi = first[c2];
+
+    if (lo > hi)
+        std::swap(lo, hi);
+
+    // cover [lo, hi] with two overlapping ranges of size 2^k
+    std::size_t k = floor_log[hi - lo + 1];
+
+    return shallower(sparse[k][lo], sparse[k][hi + 1 - (std::size_t(1) << k)]);
+}
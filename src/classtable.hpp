@@ -0,0 +1,109 @@
+// Table of every class in the program, including the basic classes.
+// The basic classes are in from the start with the ids of prelude.hpp. The
+// program's classes get dense ids after them in the order they are added,
+// which is also the order the code generator emits them in, so the output
+// doesn't depend on where the class nodes happen to be allocated. Once the
+// inheritance is validated the table is indexed to answer the hierarchy
+// queries of the later stages without walking the inheritance tree.
+
+#ifndef CLASSTABLE_H
+#define CLASSTABLE_H
+
+#include "ast.hpp"
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class ClassTable
+{
+public:
+    typedef int ClassId;
+    static const ClassId NO_CLASS_ID = -1;
+
+private:
+    std::vector<ClassPtr> classes; // [class id] -> class node
+    std::vector<ClassId> parents; // [class id] -> parent class id, NO_CLASS_ID for Object
+    std::unordered_map<Symbol, ClassId> ids; // class name -> class id
+
+    // Each class is numbered when a DFS of the inheritance tree enters it (pre)
+    // and when it leaves it (post). A class is a subtype of another exactly when
+    // its interval [pre, post] is nested in the other's.
+    std::vector<int> pre;
+    std::vector<int> post;
+    std::vector<ClassId> preorder; // classes sorted by pre, every class comes after its parent
+
+    // Lowest common ancestors are answered with a range minimum query over the
+    // Euler tour of the inheritance tree: the LCA of two classes is the shallowest
+    // class visited between their first occurrences in the tour. The sparse table
+    // holds the shallowest class of every power of 2 sized range of the tour.
+    std::vector<ClassId> euler; // classes in the order the DFS visits them, with repeats
+    std::vector<int> depth; // [class id] -> number of ancestors
+    std::vector<std::size_t> first; // [class id] -> index of its first occurrence in euler
+    std::vector<std::vector<ClassId>> sparse; // [k][i] -> shallowest class in euler[i, i + 2^k)
+    std::vector<std::size_t> floor_log; // [n] -> floor(log2(n))
+
+    void build_sparse_table();
+
+    ClassId shallower(ClassId c1, ClassId c2) const
+    {
+        return depth[c1] <= depth[c2] ? c1 : c2;
+    }
+
+public:
+    // starts out with the basic classes and their parents
+    ClassTable();
+
+    // adds a class without a parent, returns its id or
+    // NO_CLASS_ID if a class with the same name already exists
+    ClassId add(const ClassPtr&);
+
+    void set_parent(ClassId id, ClassId parent)
+    {
+        parents[id] = parent;
+    }
+
+    // numbers the classes for is_subtype and lca. the parents must be set
+    // and free of cycles, ie. they must have passed SemanticAnalyzer::validate_inheritance
+    void build_index();
+
+    std::size_t size() const
+    {
+        return classes.size();
+    }
+
+    // id of the class with the given name, NO_CLASS_ID if there's no such class
+    ClassId find(const Symbol& name) const
+    {
+        auto it = ids.find(name);
+        return it == end(ids) ? NO_CLASS_ID : it->second;
+    }
+
+    const ClassPtr& get_class(ClassId id) const
+    {
+        return classes[id];
+    }
+
+    ClassId get_parent(ClassId id) const
+    {
+        return parents[id];
+    }
+
+    bool is_subtype(ClassId child, ClassId parent) const
+    {
+        return pre[parent] <= pre[child] && post[child] <= post[parent];
+    }
+
+    const std::vector<ClassId>& get_preorder() const
+    {
+        return preorder;
+    }
+
+    // false if either of the names isn't a class
+    bool is_subtype(const Symbol&, const Symbol&) const;
+
+    // lowest common ancestor of two classes in constant time
+    ClassId lca(ClassId, ClassId) const;
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "compilepipeline.hpp"
+#include "astnodecodegenerator.hpp"
+#include "astnodetypechecker.hpp"
+#include "prelude.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // enough batches for code generation to start early and keep up
+    const std::size_t NUM_BATCHES = 64;
+
+    // batches with fewer classes than this aren't worth handing over
+    const std::size_t MIN_BATCH_SIZE = 16;
+
+    // times code generation looks at a batch before it sleeps until the
+    // batch is checked, a batch is often done by then
+    const int SPIN_COUNT = 1000;
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void print_stage(std::ostream& os, const char* name, const StageStats& stats, const char* stall)
+    {
+        os << "  " << name << ": " << stats.batches << " batches, busy " << stats.busy
+           << "s, waited " << stats.stall << "s " << stall << ", queue depth up to " << stats.max_depth << "\n";
+    }
+}
+
+StageStats::StageStats()
+    : batches(0), max_depth(0), busy(0), stall(0)
+{
+
+}
+
+const std::size_t CompilePipeline::DEFAULT_QUEUE_SIZE;
+
+CompilePipeline::CompilePipeline(CompilerContext& context, const ClassTable& ct, const ClassLayout& cl,
+        std::size_t queue)
+    : ctx(context), class_table(ct), class_layout(cl), queue_size(std::max<std::size_t>(queue, 1)), started(0)
+{
+    std::size_t num_classes = class_table.size();
+    std::size_t batch_size = std::max(MIN_BATCH_SIZE, (num_classes + NUM_BATCHES - 1) / NUM_BATCHES);
+
+    for (std::size_t begin = 0; begin < num_classes; begin += batch_size)
+        batches.emplace_back(begin, std::min(begin + batch_size, num_classes));
+}
+
+void CompilePipeline::check(Batch& batch)
+{
+    started.fetch_add(1, std::memory_order_relaxed);
+
+    Clock::time_point start = Clock::now();
+    AstNodeTypeChecker typechecker(ctx.sources, class_table, class_layout);
+
+    // the basic classes are known to be right, they're only generated
+    std::size_t begin = std::max<std::size_t>(batch.begin, prelude::CLASS_COUNT);
+
+    for (std::size_t id = begin; id < batch.end; ++id)
+        typechecker.check_overrides(*class_table.get_class(id));
+
+    batch.override_errors.swap(typechecker.diagnostics);
+
+    for (std::size_t id = begin; id < batch.end; ++id)
+        class_table.get_class(id)->accept(typechecker);
+
+    batch.body_errors.swap(typechecker.diagnostics);
+    batch.error_count = typechecker.get_err_count();
+
+    // set under the lock so that code generation can't miss the wake up
+    // between finding the batch unchecked and going to sleep
+    std::lock_guard<std::mutex> lock(mutex);
+    batch.checked_at = Clock::now();
+    check_stats.busy += std::chrono::duration<double>(batch.checked_at - start).count();
+    ++check_stats.batches;
+    batch.checked.store(true, std::memory_order_release);
+    batch_checked.notify_one();
+}
+
+void CompilePipeline::wait_checked(Batch& batch)
+{
+    for (int i = 0; i < SPIN_COUNT; ++i)
+        if (batch.checked.load(std::memory_order_acquire))
+            return;
+
+    Clock::time_point start = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    batch_checked.wait(lock, [&batch]() { return batch.checked.load(std::memory_order_acquire); });
+
+    codegen_stats.stall += seconds_since(start);
+}
+
+void CompilePipeline::generate(ThreadPool& pool)
+{
+    AstNodeCodeGenerator codegen(ctx.constants, class_table, class_layout, code);
+    bool failed = false;
+
+    // the workers get a batch each and up to queue_size more to check
+    // ahead of code generation
+    std::size_t ahead = pool.size() + queue_size;
+    std::size_t submitted = 0;
+
+    auto submit = [this, &pool, &submitted]()
+    {
+        Batch* batch = &batches[submitted++];
+        pool.submit([this, batch]() { check(*batch); });
+
+        std::size_t waiting = submitted - started.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        check_stats.max_depth = std::max(check_stats.max_depth, waiting);
+    };
+
+    while (submitted < std::min(ahead, batches.size()))
+        submit();
+
+    for (std::size_t i = 0; i < batches.size(); ++i)
+    {
+        Batch& batch = batches[i];
+        wait_checked(batch);
+
+        std::size_t depth = 0;
+        for (std::size_t j = i; j < submitted; ++j)
+            depth += batches[j].checked.load(std::memory_order_acquire) ? 1 : 0;
+
+        codegen_stats.max_depth = std::max(codegen_stats.max_depth, depth);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            check_stats.stall += seconds_since(batch.checked_at);
+        }
+
+        if (submitted < batches.size())
+            submit();
+
+        // the nodes of a class with errors may refer to classes and methods
+        // that don't exist, and the code won't be used anyway
+        failed = failed || batch.error_count > 0;
+        if (failed)
+            continue;
+
+        Clock::time_point start = Clock::now();
+
+        for (std::size_t id = batch.begin; id < batch.end; ++id)
+            class_table.get_class(id)->accept(codegen);
+
+        codegen_stats.busy += seconds_since(start);
+        ++codegen_stats.batches;
+    }
+}
+
+bool CompilePipeline::run(ThreadPool& pool)
+{
+    generate(pool);
+    pool.wait();
+
+    std::size_t errors = 0;
+    for (auto& batch : batches)
+    {
+        ctx.errors << batch.override_errors;
+        errors += batch.error_count;
+    }
+
+    for (auto& batch : batches)
+        ctx.errors << batch.body_errors;
+
+    return errors == 0;
+}
+
+void CompilePipeline::write_code(std::ostream& os)
+{
+    os << code.str();
+}
+
+void CompilePipeline::print_stats(std::ostream& os) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << std::fixed << std::setprecision(3);
+    os << "pipeline: " << batches.size() << " batches, " << queue_size
+       << " checked batches can wait for code generation\n";
+    print_stage(os, "check", check_stats, "for code generation");
+    print_stage(os, "codegen", codegen_stats, "for input");
+
+    os.flags(flags);
+    os.precision(precision);
+}
@@ -0,0 +1,102 @@
+// Type checks the classes of a program and generates their code at the same
+// time. Once the class table and layout are built, the classes are cut into
+// batches in class id order. The batches are checked by the workers of the
+// thread pool, several at once, and the calling thread generates their code
+// in order as they come out, so the code of the first batches is generated
+// while the later ones are still being checked. Batches are only handed to
+// the workers while code generation keeps up: no more than one per worker
+// and queue_size more are checked ahead of it. A batch with type errors
+// isn't generated, and the code is only written out if no batch had errors.
+// Errors are printed in the order a serial check prints them.
+
+#ifndef COMPILEPIPELINE_H
+#define COMPILEPIPELINE_H
+
+#include "classtable.hpp"
+#include "classlayout.hpp"
+#include "compilercontext.hpp"
+#include "threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// What one stage of the pipeline did, to tune the size of the queue
+class StageStats
+{
+public:
+    std::size_t batches; // batches the stage worked on
+    std::size_t max_depth; // most batches waiting for the stage at once: for a worker, or checked for code generation
+    double busy; // seconds spent working on batches, summed over the workers
+    double stall; // seconds checked batches waited for code generation, or code generation waited for a batch
+
+    StageStats();
+};
+
+class CompilePipeline
+{
+private:
+    // classes with the ids in [begin, end)
+    class Batch
+    {
+    public:
+        std::size_t begin;
+        std::size_t end;
+        std::string override_errors; // printed before the errors of any class body
+        std::string body_errors;
+        std::size_t error_count;
+        std::chrono::steady_clock::time_point checked_at;
+        std::atomic<bool> checked; // set once the fields above are
+
+        Batch(std::size_t b, std::size_t e)
+            : begin(b), end(e), error_count(0), checked(false)
+        {
+
+        }
+    };
+
+    CompilerContext& ctx; // errors are printed to ctx.errors
+    const ClassTable& class_table;
+    const ClassLayout& class_layout;
+    std::deque<Batch> batches; // a deque since batches can't be moved
+    std::size_t queue_size;
+    std::ostringstream code; // the code of every class generated so far
+    std::atomic<std::size_t> started; // batches a worker started checking
+    StageStats check_stats;
+    StageStats codegen_stats;
+
+    std::mutex mutex; // guards check_stats and the wait for a batch
+    std::condition_variable batch_checked;
+
+    void check(Batch&);
+    void wait_checked(Batch&);
+    void generate(ThreadPool&);
+
+public:
+    // default number of checked batches that can wait for code generation
+    static const std::size_t DEFAULT_QUEUE_SIZE = 4;
+
+    // the class table must have been indexed and laid out
+    CompilePipeline(CompilerContext&, const ClassTable&, const ClassLayout&,
+            std::size_t queue_size = DEFAULT_QUEUE_SIZE);
+
+    CompilePipeline(const CompilePipeline&) = delete;
+    CompilePipeline& operator=(const CompilePipeline&) = delete;
+
+    // runs both stages until every class is done, returns whether the
+    // program type checks
+    bool run(ThreadPool&);
+
+    // writes the code of the classes, which comes after the data section
+    void write_code(std::ostream&);
+
+    void print_stats(std::ostream&) const;
+};
+
+#endif
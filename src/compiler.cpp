@@ -0,0 +1,246 @@
+#include "compiler.hpp"
+#include "astnodecodegenerator.hpp"
+#include "astnodevisitor.hpp"
+#include "compilepipeline.hpp"
+#include "lazymethods.hpp"
+#include "parsedriver.hpp"
+#include "semanticanalyzer.hpp"
+#include "sourcebuffer.hpp"
+#include "utility.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+    // Registers and parses one source and adds its classes to the ones
+    // parsed so far, returns the number of lexical and syntax errors found
+    std::size_t parse_source(CompilerContext& compiler, SourceBuffer& src, const std::string& name,
+            const CompileOptions& opts, Classes& classes)
+    {
+        SourceLocation::FileId file = compiler.sources.add_file(name, src.size());
+        if (file == SourceLocation::NO_FILE)
+        {
+            utility::print_error(compiler.errors, name, "too many source lines");
+            return 1;
+        }
+
+        ParseContext ctx(compiler, compiler.arena, opts.lexer, opts.parser);
+        ctx.lazy_methods = opts.lazy_methods;
+        ProgramPtr program = ctx.parse(src, file);
+
+        compiler.errors << ctx.diagnostics;
+        if (program)
+            classes.insert(classes.end(), program->classes.begin(), program->classes.end());
+
+        if (ctx.error_count == 0)
+            compiler.constants.add_all(ctx.constants);
+
+        return ctx.error_count;
+    }
+
+    // One program of a manifest
+    class BatchJob
+    {
+    public:
+        std::string output;
+        std::vector<std::string> files;
+        std::ostringstream errors;
+        bool compiled;
+
+        BatchJob()
+            : compiled(false)
+        {
+
+        }
+    };
+}
+
+CompileOptions::CompileOptions()
+    : lexer(FLEX_LEXER), parser(BISON_PARSER), lazy_methods(false), pipeline(false),
+      pipeline_stats(false), queue_size(CompilePipeline::DEFAULT_QUEUE_SIZE), print_ast(true)
+{
+
+}
+
+bool compile(CompilerContext& ctx, const std::vector<std::string>& files, const std::string& output,
+        const CompileOptions& opts, ThreadPool* pool)
+{
+    Classes classes;
+    std::size_t syntax_errors = 0;
+
+    if (files.empty())
+    {
+        SourceBuffer src;
+
+        if (src.load_stdin())
+        {
+            syntax_errors += parse_source(ctx, src, "<stdin>", opts, classes);
+        }
+        else
+        {
+            utility::print_error(ctx.errors, "<stdin>", "cannot be read");
+        }
+    }
+    else if (!pool || pool->size() == 1)
+    {
+        for (auto& file : files)
+        {
+            SourceBuffer src;
+
+            if (src.load_file(file))
+            {
+                syntax_errors += parse_source(ctx, src, file, opts, classes);
+            }
+            else
+            {
+                utility::print_error(ctx.errors, file, "cannot be opened");
+            }
+        }
+    }
+    else
+    {
+        syntax_errors += parse_files(ctx, files, opts.lexer, opts.parser, opts.lazy_methods, *pool, classes);
+    }
+
+    // the bodies the parser skipped are parsed before anything looks at them
+    if (opts.lazy_methods && syntax_errors == 0)
+        syntax_errors += parse_reachable_methods(ctx, classes);
+
+    std::ofstream out;
+    auto open_output = [&ctx, &out, &output]() -> std::ostream*
+    {
+        out.open(output);
+        if (!out)
+        {
+            utility::print_error(ctx.errors, output, "cannot be written");
+            return nullptr;
+        }
+
+        return &out;
+    };
+
+    return compile_classes(ctx, std::move(classes), syntax_errors, opts, pool, open_output);
+}
+
+bool compile_classes(CompilerContext& ctx, Classes classes, std::size_t syntax_errors, const CompileOptions& opts,
+        ThreadPool* pool, const std::function<std::ostream*()>& open_output)
+{
+    ctx.program = ctx.arena.make<Program>(std::move(classes));
+
+    if (syntax_errors > 0)
+    {
+        ctx.errors << "Compilation halted due to lexical or syntax errors.\n";
+        return false;
+    }
+
+    SemanticAnalyzer semant(ctx);
+    if (!semant.validate_inheritance(ctx.program->classes))
+    {
+        ctx.errors << "Compilation halted due to inheritance errors.\n";
+        return false;
+    }
+
+    // the pipeline generates the code of the classes as they are checked,
+    // it's only written out once the whole program is known to type check.
+    // Its stages run on two threads, so it needs the pool
+    std::unique_ptr<CompilePipeline> stages;
+    if (opts.pipeline && pool)
+        stages.reset(new CompilePipeline(ctx, semant.get_class_table(), semant.get_class_layout(), opts.queue_size));
+
+    bool type_checks = stages ? stages->run(*pool) : semant.type_check(ctx.program, pool);
+
+    if (stages && opts.pipeline_stats)
+        stages->print_stats(ctx.errors);
+
+    if (!type_checks)
+    {
+        ctx.errors << "Compilation halted due to type errors.\n";
+        return false;
+    }
+
+    if (opts.print_ast)
+    {
+        AstNodeDisplayer print(std::cout, AstNodeDisplayer::DISPLAYNONBASIC);
+        ctx.program->accept(print);
+    }
+
+    std::ostream* out = open_output();
+    if (!out)
+        return false;
+
+    AstNodeCodeGenerator codegen(ctx.constants, semant.get_class_table(), semant.get_class_layout(), *out, pool);
+
+    if (stages)
+    {
+        codegen.code_data();
+        stages->write_code(*out);
+    }
+    else
+    {
+        ctx.program->accept(codegen);
+    }
+
+    return true;
+}
+
+bool compile_batch(const std::string& manifest, const CompileOptions& opts, ThreadPool& pool)
+{
+    std::ifstream in(manifest);
+    if (!in)
+    {
+        utility::print_error(manifest, "cannot be opened");
+        return false;
+    }
+
+    std::vector<std::unique_ptr<BatchJob>> jobs;
+    std::string line;
+
+    for (std::size_t line_no = 1; std::getline(in, line); ++line_no)
+    {
+        std::unique_ptr<BatchJob> job(new BatchJob);
+        std::istringstream fields(line);
+        std::string file;
+
+        if (!(fields >> job->output) || job->output[0] == '#')
+            continue;
+
+        while (fields >> file)
+            job->files.push_back(file);
+
+        if (job->files.empty())
+        {
+            utility::print_error(std::cerr, manifest, line_no, "no source files for " + job->output);
+            return false;
+        }
+
+        jobs.push_back(std::move(job));
+    }
+
+    // the programs are small and many, so each is compiled by one task
+    // rather than spread over the pool
+    for (auto& job : jobs)
+    {
+        BatchJob* j = job.get();
+        const CompileOptions* o = &opts;
+        pool.submit([j, o]()
+        {
+            CompilerContext ctx(j->errors);
+            j->compiled = compile(ctx, j->files, j->output, *o, nullptr);
+        });
+    }
+
+    pool.wait();
+
+    bool status = true;
+    for (auto& job : jobs)
+    {
+        std::cerr << job->errors.str();
+        status = status && job->compiled;
+    }
+
+    return status;
+}
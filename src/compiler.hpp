@@ -0,0 +1,56 @@
+// Drives a compilation through its phases: parsing, semantic analysis and
+// code generation, with the state of the compilation in a CompilerContext.
+// A single program may use a thread pool within its phases. In batch mode
+// the programs of a manifest are compiled at the same time instead, each by
+// one task of the pool and each with a context of its own.
+
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "compilercontext.hpp"
+#include "parsecontext.hpp"
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class CompileOptions
+{
+public:
+    LexerKind lexer;
+    ParserKind parser;
+    bool lazy_methods; // see lazymethods.hpp, needs the hand lexer and parser
+    bool pipeline; // check and generate the classes at once, see compilepipeline.hpp
+    bool pipeline_stats;
+    std::size_t queue_size; // of the pipeline
+    bool print_ast; // print the typed AST to std::cout
+
+    CompileOptions();
+};
+
+// Compiles the files, or the standard input if there are none, into the
+// output file. Errors are printed to the context's errors. The phases use
+// the pool if there is one, otherwise everything is done on the calling
+// thread. Returns whether the program compiled
+bool compile(CompilerContext&, const std::vector<std::string>& files, const std::string& output,
+        const CompileOptions&, ThreadPool*);
+
+// The phases after parsing: checks the classes parsed from the sources of
+// the compilation, syntax_errors of them, and generates their code. The
+// stream to write the code to is only asked for once the program is known to
+// type check, open_output reports why if it can't give one and returns
+// nullptr. Used by compile and by the compile server, whose classes may come
+// from earlier compilations
+bool compile_classes(CompilerContext&, Classes, std::size_t syntax_errors, const CompileOptions&, ThreadPool*,
+        const std::function<std::ostream*()>& open_output);
+
+// Compiles every program of a manifest. Each line of the manifest has the
+// output file of a program followed by its source files, blank lines and
+// lines starting with '#' are skipped. The errors of each program are
+// printed in the order of the manifest. Returns whether all programs compiled
+bool compile_batch(const std::string& manifest, const CompileOptions&, ThreadPool&);
+
+#endif
@@ -0,0 +1,45 @@
+// Everything one compilation owns: its AST, its source files and its pool
+// of constants, along with where its errors go. The phases are handed the context of the compilation they work
+// on instead of reaching for globals, so several compilations can run in one
+// process at the same time, each with a context of its own. What they share
+// is safe to share: the symbol pool is locked, and the basic classes of
+// prelude.hpp are never changed.
+
+#ifndef COMPILERCONTEXT_H
+#define COMPILERCONTEXT_H
+
+#include "ast.hpp"
+#include "astarena.hpp"
+#include "constantpool.hpp"
+#include "sourcemanager.hpp"
+
+#include <ostream>
+
+class CompilerContext
+{
+public:
+    AstArena arena; // owns every AST node of the compilation
+    SourceManager sources;
+    ConstantPool constants;
+    ProgramPtr program; // root of the AST, set once the sources are parsed
+    std::ostream& errors; // where the errors of the compilation are printed
+
+    explicit CompilerContext(std::ostream& errs)
+        : program(nullptr), errors(errs)
+    {
+
+    }
+
+    // a compilation whose sources are layered over files registered
+    // before, see SourceManager
+    CompilerContext(std::ostream& errs, const SourceManager& files)
+        : sources(&files), program(nullptr), errors(errs)
+    {
+
+    }
+
+    CompilerContext(const CompilerContext&) = delete;
+    CompilerContext& operator=(const CompilerContext&) = delete;
+};
+
+#endif
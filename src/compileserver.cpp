@@ -0,0 +1,569 @@
+#include "compileserver.hpp"
+#include "parsecontext.hpp"
+#include "sourcebuffer.hpp"
+#include "utility.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // time a client has to send its request and read the answer, the
+    // server serves nobody else meanwhile
+    const std::chrono::seconds REQUEST_TIMEOUT(10);
+
+    // longest text a request can send
+    const std::size_t MAX_TEXT_SIZE = 64 * 1024 * 1024;
+
+    // files parsed again or gone whose lines the server keeps indexes for,
+    // beyond one per cached file, before it starts the cache over
+    const std::size_t MAX_STALE_FILES = 1024;
+
+    // Reads the lines and blocks of bytes of a request or an answer from a
+    // socket, and writes whole strings to it. Closes the socket when done.
+    // With a deadline, the connection is treated as ended once it passes
+    class Connection
+    {
+    private:
+        int fd;
+        bool has_deadline;
+        Clock::time_point deadline;
+        std::string pending; // read from the socket but not consumed yet
+
+        // waits until the socket is ready for events, false if the deadline
+        // passes first
+        bool wait_ready(short events)
+        {
+            if (!has_deadline)
+                return true;
+
+            for (;;)
+            {
+                Clock::duration left = deadline - Clock::now();
+                if (left <= Clock::duration::zero())
+                    return false;
+
+                pollfd p = { fd, events, 0 };
+                int n = ::poll(&p, 1, static_cast<int>(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(left).count() + 1));
+
+                if (n > 0)
+                    return true;
+
+                if (n < 0 && errno != EINTR)
+                    return false;
+            }
+        }
+
+        // reads more into pending, returns false at the end of the input
+        bool fill()
+        {
+            char chunk[64 * 1024];
+            ssize_t n;
+
+            do
+            {
+                if (!wait_ready(POLLIN))
+                    return false;
+
+                n = ::read(fd, chunk, sizeof(chunk));
+            } while (n < 0 && errno == EINTR);
+
+            if (n <= 0)
+                return false;
+
+            pending.append(chunk, static_cast<std::size_t>(n));
+            return true;
+        }
+
+    public:
+        explicit Connection(int sock)
+            : fd(sock), has_deadline(false)
+        {
+
+        }
+
+        Connection(int sock, Clock::duration timeout)
+            : fd(sock), has_deadline(true), deadline(Clock::now() + timeout)
+        {
+
+        }
+
+        ~Connection()
+        {
+            ::close(fd);
+        }
+
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        // the next line without its newline, false if there is none
+        bool read_line(std::string& line)
+        {
+            std::size_t newline;
+
+            while ((newline = pending.find('\n')) == std::string::npos)
+                if (!fill())
+                    return false;
+
+            line.assign(pending, 0, newline);
+            pending.erase(0, newline + 1);
+            return true;
+        }
+
+        bool read_bytes(std::size_t len, std::string& bytes)
+        {
+            while (pending.size() < len)
+                if (!fill())
+                    return false;
+
+            bytes.assign(pending, 0, len);
+            pending.erase(0, len);
+            return true;
+        }
+
+        bool write_all(const std::string& bytes)
+        {
+            std::size_t written = 0;
+
+            while (written < bytes.size())
+            {
+                if (!wait_ready(POLLOUT))
+                    return false;
+
+                ssize_t n = ::write(fd, bytes.data() + written, bytes.size() - written);
+
+                if (n < 0 && errno == EINTR)
+                    continue;
+
+                if (n <= 0)
+                    return false;
+
+                written += static_cast<std::size_t>(n);
+            }
+
+            return true;
+        }
+    };
+
+    bool make_address(const std::string& path, sockaddr_un& addr)
+    {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+
+        if (path.size() >= sizeof(addr.sun_path))
+        {
+            utility::print_error(path, "socket path too long");
+            return false;
+        }
+
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    bool same_time(const timespec& a, const timespec& b)
+    {
+        return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+    }
+
+    // the line an answer starts with
+    std::string answer_header(bool compiled, std::size_t errors_len, std::size_t code_len)
+    {
+        std::ostringstream header;
+        header << (compiled ? 0 : 1) << " " << errors_len << " " << code_len << "\n";
+        return header.str();
+    }
+}
+
+CompileServer::CompileServer(const std::string& path, const CompileOptions& options, ThreadPool& workers)
+    : socket_path(path), opts(options), pool(workers), parsed(std::cerr)
+{
+    opts.lazy_methods = false;
+    opts.print_ast = false;
+}
+
+const CompileServer::CachedFile* CompileServer::load(const std::string& path, bool& full)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+    {
+        cache.erase(path);
+        return nullptr;
+    }
+
+    std::unique_ptr<CachedFile>& entry = cache[path];
+    // a file that couldn't be registered is tried again
+    if (entry && entry->file != SourceLocation::NO_FILE && entry->size == st.st_size
+            && same_time(entry->mtime, st.st_mtim))
+        return entry.get();
+
+    SourceBuffer src;
+    if (!src.load_file(path))
+    {
+        cache.erase(path);
+        return nullptr;
+    }
+
+    // a file parsed again is registered again, it may have more lines than
+    // its old id has room for. The nodes of the old parse go with the old entry
+    SourceLocation::FileId file = parsed.sources.add_file(path, src.size());
+    entry.reset(new CachedFile);
+    entry->file = file;
+    entry->size = st.st_size;
+    entry->mtime = st.st_mtim;
+
+    if (file == SourceLocation::NO_FILE)
+    {
+        full = true;
+
+        std::ostringstream err;
+        utility::print_error(err, path, "too many source lines");
+        entry->diagnostics = err.str();
+        entry->error_count = 1;
+        return entry.get();
+    }
+
+    ParseContext ctx(parsed, entry->arena, opts.lexer, opts.parser);
+    ProgramPtr program = ctx.parse(src, file);
+
+    if (program)
+        entry->classes = program->classes;
+
+    entry->constants = ctx.constants;
+    entry->diagnostics.swap(ctx.diagnostics);
+    entry->error_count = ctx.error_count;
+    return entry.get();
+}
+
+std::vector<const CompileServer::CachedFile*> CompileServer::load_all(const Request& request, bool& full)
+{
+    std::vector<const CachedFile*> files;
+    for (auto& input : request.inputs)
+        if (!input.is_text)
+            files.push_back(load(input.name, full));
+
+    return files;
+}
+
+void CompileServer::reset()
+{
+    cache.clear();
+    parsed.sources = SourceManager();
+}
+
+std::string CompileServer::compile(const Request& request)
+{
+    // A file parsed again is registered again and a file gone from the
+    // cache stays registered, the indexes of their old lines are only
+    // given back by starting the cache over. That's done when they
+    // outnumber the cached files, and when the indexes run out
+    std::size_t registered = parsed.sources.file_count() - 1;
+    if (registered > 2 * cache.size() + MAX_STALE_FILES)
+        reset();
+
+    // the files are loaded first since that may register them
+    bool full = false;
+    std::vector<const CachedFile*> files = load_all(request, full);
+    if (full)
+    {
+        reset();
+        full = false;
+        files = load_all(request, full);
+    }
+
+    // only the texts are registered with the compilation, the cached
+    // files are known to it through the sources under it
+    std::ostringstream errors;
+    CompilerContext ctx(errors, parsed.sources);
+
+    Classes classes;
+    std::size_t syntax_errors = 0;
+    std::size_t next_file = 0;
+
+    for (auto& input : request.inputs)
+    {
+        if (input.is_text)
+        {
+            SourceBuffer src;
+            src.load_text(input.text.data(), input.text.size());
+
+            SourceLocation::FileId file = ctx.sources.add_file(input.name, src.size());
+            if (file == SourceLocation::NO_FILE)
+            {
+                utility::print_error(ctx.errors, input.name, "too many source lines");
+                ++syntax_errors;
+                continue;
+            }
+
+            ParseContext parse(ctx, ctx.arena, opts.lexer, opts.parser);
+            ProgramPtr program = parse.parse(src, file);
+
+            ctx.errors << parse.diagnostics;
+            if (program)
+                classes.insert(classes.end(), program->classes.begin(), program->classes.end());
+
+            if (parse.error_count == 0)
+                ctx.constants.add_all(parse.constants);
+
+            syntax_errors += parse.error_count;
+            continue;
+        }
+
+        const CachedFile* file = files[next_file++];
+        if (!file)
+        {
+            utility::print_error(ctx.errors, input.name, "cannot be opened");
+            continue;
+        }
+
+        ctx.errors << file->diagnostics;
+        classes.insert(classes.end(), file->classes.begin(), file->classes.end());
+
+        // the nodes are numbered again in this compilation's pool
+        if (file->error_count == 0)
+        {
+            LocalConstants constants = file->constants;
+            ctx.constants.add_all(constants);
+        }
+
+        syntax_errors += file->error_count;
+    }
+
+    std::ostringstream code;
+    bool compiled = compile_classes(ctx, std::move(classes), syntax_errors, opts, &pool,
+            [&code]() -> std::ostream* { return &code; });
+
+    if (compiled && !request.output.empty())
+    {
+        std::ofstream out(request.output);
+
+        if (!(out << code.str()))
+        {
+            utility::print_error(ctx.errors, request.output, "cannot be written");
+            compiled = false;
+        }
+    }
+
+    std::string code_text = compiled ? code.str() : std::string();
+    std::string errors_text = errors.str();
+
+    return answer_header(compiled, errors_text.size(), code_text.size()) + errors_text + code_text;
+}
+
+bool CompileServer::run()
+{
+    sockaddr_un addr;
+    if (!make_address(socket_path, addr))
+        return false;
+
+    int sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0)
+    {
+        utility::print_error(socket_path, std::strerror(errno));
+        return false;
+    }
+
+    // a socket left behind by a server that didn't shut down is replaced,
+    // anything else at the path is left alone
+    struct stat st;
+    if (::lstat(socket_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+        ::unlink(socket_path.c_str());
+
+    // only the server's user may connect, since requests read and write
+    // files as that user. The socket is created without access for others
+    // rather than changed after, when someone may have connected already
+    mode_t mask = ::umask(077);
+    bool bound = ::bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    ::umask(mask);
+
+    if (!bound || ::listen(sock, SOMAXCONN) != 0)
+    {
+        utility::print_error(socket_path, std::strerror(errno));
+        ::close(sock);
+        return false;
+    }
+
+    // a client that goes away before its answer is written mustn't take
+    // the server with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    bool serving = true;
+    while (serving)
+    {
+        int client = ::accept(sock, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            utility::print_error(socket_path, std::strerror(errno));
+            break;
+        }
+
+        Connection conn(client, REQUEST_TIMEOUT);
+        Request request;
+        std::string line;
+        std::string error;
+        std::string answer;
+
+        while (answer.empty() && error.empty() && conn.read_line(line))
+        {
+            std::istringstream fields(line);
+            std::string command;
+            fields >> command;
+
+            if (command == "file" && line.size() > 5)
+            {
+                request.inputs.push_back(Input { false, line.substr(5), std::string() });
+            }
+            else if (command == "text")
+            {
+                std::size_t len;
+                std::string name = "<text>";
+
+                if (!(fields >> len))
+                {
+                    error = "text without a length";
+                }
+                else if (len > MAX_TEXT_SIZE)
+                {
+                    error = "text longer than " + std::to_string(MAX_TEXT_SIZE) + " bytes";
+                }
+                else
+                {
+                    fields >> name;
+                    request.inputs.push_back(Input { true, name, std::string() });
+
+                    // a text cut short ends the connection, nothing is answered
+                    if (!conn.read_bytes(len, request.inputs.back().text))
+                        break;
+                }
+            }
+            else if (command == "output" && line.size() > 7)
+            {
+                request.output = line.substr(7);
+            }
+            else if (command == "compile")
+            {
+                answer = compile(request);
+            }
+            else if (command == "shutdown")
+            {
+                answer = answer_header(true, 0, 0);
+                serving = false;
+            }
+            else
+            {
+                error = "unknown request '" + line + "'";
+            }
+        }
+
+        if (!error.empty())
+        {
+            std::ostringstream errors;
+            utility::print_error(errors, socket_path, error);
+            answer = answer_header(false, errors.str().size(), 0) + errors.str();
+        }
+
+        // a request cut short gets no answer, there is no one left to read it
+        if (!answer.empty())
+            conn.write_all(answer);
+    }
+
+    ::close(sock);
+    ::unlink(socket_path.c_str());
+    return true;
+}
+
+bool compile_remote(const std::string& socket_path, const std::vector<std::string>& files,
+        const std::string& output)
+{
+    std::string request;
+    std::string cwd;
+
+    // the server has a directory of its own
+    char buf[PATH_MAX];
+    if (::getcwd(buf, sizeof(buf)))
+        cwd = std::string(buf) + "/";
+
+    for (auto& file : files)
+        request += "file " + (file[0] == '/' ? file : cwd + file) + "\n";
+
+    if (files.empty())
+    {
+        SourceBuffer src;
+        if (!src.load_stdin())
+        {
+            utility::print_error("<stdin>", "cannot be read");
+            return false;
+        }
+
+        request += "text " + std::to_string(src.size()) + " <stdin>\n";
+        request.append(src.data(), src.size());
+    }
+
+    request += "compile\n";
+
+    sockaddr_un addr;
+    if (!make_address(socket_path, addr))
+        return false;
+
+    int sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0 || ::connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        utility::print_error(socket_path, std::string("cannot reach the compile server: ") + std::strerror(errno));
+        if (sock >= 0)
+            ::close(sock);
+
+        return false;
+    }
+
+    Connection conn(sock);
+    std::string header;
+    std::string errors;
+    std::string code;
+    int status;
+    std::size_t errors_len;
+    std::size_t code_len;
+
+    if (!conn.write_all(request) || !conn.read_line(header))
+    {
+        utility::print_error(socket_path, "the compile server didn't answer");
+        return false;
+    }
+
+    std::istringstream fields(header);
+    if (!(fields >> status >> errors_len >> code_len) || !conn.read_bytes(errors_len, errors) ||
+            !conn.read_bytes(code_len, code))
+    {
+        utility::print_error(socket_path, "the compile server's answer is cut short");
+        return false;
+    }
+
+    std::cerr << errors;
+    if (status != 0)
+        return false;
+
+    std::ofstream out(output);
+    if (!(out << code))
+    {
+        utility::print_error(output, "cannot be written");
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,128 @@
+// A compiler that stays up between compilations, started with --server. It
+// listens on a Unix domain socket and compiles one request per connection,
+// so that tools compiling again and again don't pay for starting a process
+// and for work that was done before. Besides the symbol pool, the basic
+// classes and the thread pool, which live as long as the process, the
+// server keeps the classes parsed from every source file along with the
+// arena they are in. A file is only parsed again once its size or
+// modification time changes; the checks and code generation, which depend
+// on the whole program, are done for every request.
+//
+// A request is a sequence of lines:
+//
+//   file <path>              a source file, relative to the server's directory
+//   text <length> [<name>]   followed by <length> bytes of source, never cached
+//   output <path>            where the server writes the code, optional
+//   compile                  ends the request
+//
+// or the single line "shutdown", which stops the server. Sources are
+// compiled in the order given. The answer is the line
+//
+//   <status> <length of errors> <length of code>
+//
+// followed by the errors and the code, status being 0 if the program
+// compiled and 1 otherwise, like the exit status of coolc. There is no code
+// unless the program compiled.
+//
+// Only the user running the server can connect to its socket. The server
+// answers one connection at a time. A client that hasn't sent
+// its request and read the answer within a few seconds of connecting is
+// dropped without one, and a text can be at most 64 MB long.
+
+#ifndef COMPILESERVER_H
+#define COMPILESERVER_H
+
+#include "ast.hpp"
+#include "astarena.hpp"
+#include "compiler.hpp"
+#include "compilercontext.hpp"
+#include "constantpool.hpp"
+#include "sourcemanager.hpp"
+#include "threadpool.hpp"
+
+#include <ctime>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+class CompileServer
+{
+private:
+    // a source file as it was last parsed
+    class CachedFile
+    {
+    public:
+        SourceLocation::FileId file;
+        off_t size;
+        timespec mtime;
+        AstArena arena; // owns the nodes of the classes
+        Classes classes;
+        LocalConstants constants; // added to the pool of every compilation, in source order
+        std::string diagnostics;
+        std::size_t error_count;
+
+        CachedFile()
+            : file(SourceLocation::NO_FILE), size(0), mtime(), error_count(0)
+        {
+
+        }
+    };
+
+    // a source of a request
+    class Input
+    {
+    public:
+        bool is_text;
+        std::string name; // path of the file or name of the text
+        std::string text;
+    };
+
+    class Request
+    {
+    public:
+        std::vector<Input> inputs; // in the order given
+        std::string output;
+    };
+
+    std::string socket_path;
+    CompileOptions opts;
+    ThreadPool& pool;
+    CompilerContext parsed; // the cached files are parsed in this context, its sources name them all
+    std::unordered_map<std::string, std::unique_ptr<CachedFile>> cache; // path -> file
+
+    // the cached file at path, parsed again if it changed, or nullptr if
+    // the file can't be read. Sets full if the file couldn't be registered
+    const CachedFile* load(const std::string& path, bool& full);
+
+    // loads the files of a request in order
+    std::vector<const CachedFile*> load_all(const Request&, bool& full);
+
+    // drops every cached file and registration
+    void reset();
+
+    // compiles the sources of a request, returns the answer
+    std::string compile(const Request&);
+
+public:
+    // Method bodies are always parsed, since the nodes are kept, and the
+    // AST is never printed
+    CompileServer(const std::string& socket_path, const CompileOptions&, ThreadPool&);
+
+    CompileServer(const CompileServer&) = delete;
+    CompileServer& operator=(const CompileServer&) = delete;
+
+    // Serves requests until asked to shut down. Returns false if the socket
+    // can't be set up, after printing why
+    bool run();
+};
+
+// Sends the files to the server listening on socket_path, or the standard
+// input if there are none, and writes the code to output like compile does.
+// Relative paths are made full from the current directory, which is how
+// errors then name the files. Returns whether the program compiled
+bool compile_remote(const std::string& socket_path, const std::vector<std::string>& files,
+        const std::string& output);
+
+#endif
@@ -0,0 +1,83 @@
+#include "constantpool.hpp"
+
+#include <limits>
+
+namespace
+{
+    // value of a sequence of digits, integers too big for 32 bits are
+    // clamped like reading them with a stream does
+    std::int32_t int_value(const boost::string_view& digits)
+    {
+        const std::int64_t max = std::numeric_limits<std::int32_t>::max();
+        std::int64_t value = 0;
+
+        for (char c : digits)
+        {
+            value = value * 10 + (c - '0');
+            if (value > max)
+                return max;
+        }
+
+        return static_cast<std::int32_t>(value);
+    }
+}
+
+void LocalConstants::clear()
+{
+    strings.clear();
+    ints.clear();
+}
+
+std::size_t ConstantPool::enter_string(const Symbol& sym)
+{
+    auto it = string_indexes.emplace(sym.get_id(), strings.size()).first;
+
+    if (it->second == strings.size())
+        strings.push_back(sym);
+
+    return it->second;
+}
+
+std::size_t ConstantPool::enter_int(const Symbol& sym)
+{
+    auto known = int_symbols.find(sym.get_id());
+    if (known != int_symbols.end())
+        return known->second;
+
+    // another spelling of the same value may be in already
+    std::int32_t value = int_value(sym.get_view());
+    auto it = int_indexes.emplace(value, ints.size()).first;
+
+    if (it->second == ints.size())
+        ints.push_back(value);
+
+    int_symbols.emplace(sym.get_id(), it->second);
+    return it->second;
+}
+
+std::size_t ConstantPool::add_string(const Symbol& sym)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return enter_string(sym);
+}
+
+std::size_t ConstantPool::add_int(const Symbol& sym)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return enter_int(sym);
+}
+
+void ConstantPool::add_all(LocalConstants& local)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto& node : local.strings)
+            node->index = enter_string(node->token);
+
+        for (auto& node : local.ints)
+            node->index = enter_int(node->token);
+    }
+
+    local.clear();
+}
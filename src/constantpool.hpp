@@ -0,0 +1,72 @@
+// The string and integer constants of a compilation, each stored once.
+// Constants are numbered densely in the order they are added and the number
+// is kept on the StringConst and IntConst nodes, so the code generator emits
+// the str_const<n> and int_const<n> objects by walking the pool and refers to
+// them without looking anything up. Integers are pooled by value, so 007 and
+// 7 are the same constant.
+//
+// A parse collects the constant nodes it builds in a LocalConstants and the
+// driver adds them to the pool in source order once the parse succeeded, so
+// the numbering doesn't depend on which parse finished first.
+
+#ifndef CONSTANTPOOL_H
+#define CONSTANTPOOL_H
+
+#include "ast.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Constant nodes built by one parse, not numbered yet
+class LocalConstants
+{
+public:
+    std::vector<StringConst*> strings;
+    std::vector<IntConst*> ints;
+
+    void clear();
+};
+
+class ConstantPool
+{
+private:
+    // Keyed by the id of the symbol. The symbol pool lives as long as the
+    // process, so a table as large as the pool would cost every
+    // compilation the symbols of all the ones before it
+    std::unordered_map<std::uint32_t, std::size_t> string_indexes; // symbol -> index
+    std::unordered_map<std::uint32_t, std::size_t> int_symbols; // symbol -> index
+
+    std::unordered_map<std::int32_t, std::size_t> int_indexes; // value -> index
+    std::vector<Symbol> strings; // [index] -> string
+    std::vector<std::int32_t> ints; // [index] -> value
+    std::mutex mutex;
+
+    std::size_t enter_string(const Symbol&);
+    std::size_t enter_int(const Symbol&);
+
+public:
+    // return the index of the constant, adding it first if it's new
+    std::size_t add_string(const Symbol&);
+    std::size_t add_int(const Symbol&);
+
+    // numbers the nodes, adding their constants in the order the nodes
+    // were built, and empties the list
+    void add_all(LocalConstants&);
+
+    // The constants by index. Only to be used once all constants are in,
+    // the pool isn't locked
+    const std::vector<Symbol>& get_strings() const
+    {
+        return strings;
+    }
+
+    const std::vector<std::int32_t>& get_ints() const
+    {
+        return ints;
+    }
+};
+
+#endif
@@ -6,31 +6,68 @@
 // Symbol constants to be used by different stages of the compiler
 namespace constants
 {
-    extern const Symbol OBJECT;
-    extern const Symbol INTEGER;
-    extern const Symbol BOOLEAN;
-    extern const Symbol STRING;
-    extern const Symbol IO;
-    extern const Symbol SELF;
-    extern const Symbol SELF_TYPE;
-    extern const Symbol NOCLASS;
-    extern const Symbol NOTYPE;
-    extern const Symbol PRIM_SLOT;
-    extern const Symbol ABORT;
-    extern const Symbol TYPE_NAME;
-    extern const Symbol COPY;
-    extern const Symbol MAIN;
-    extern const Symbol OUT_INT;
-    extern const Symbol IN_INT;
-    extern const Symbol IN_STRING;
-    extern const Symbol OUT_STRING;
-    extern const Symbol SUBSTR;
-    extern const Symbol LENGTH;
-    extern const Symbol CONCAT;
-    extern const Symbol ARG;
-    extern const Symbol ARG2;
-    extern const Symbol VAL;
-    extern const Symbol STR_FIELD;
+    // Ids of the symbols that the SymbolPool interns before any other symbol.
+    // The order must match PREDEFINED_SPELLINGS in constants.cpp
+    enum PredefinedId : std::uint32_t
+    {
+        EMPTY_ID, // the spelling of a default constructed Symbol
+        OBJECT_ID,
+        INTEGER_ID,
+        BOOLEAN_ID,
+        STRING_ID,
+        MAIN_ID,
+        IO_ID,
+        SELF_ID,
+        SELF_TYPE_ID,
+        NOCLASS_ID,
+        NOTYPE_ID,
+        PRIM_SLOT_ID,
+        ABORT_ID,
+        TYPE_NAME_ID,
+        COPY_ID,
+        OUT_INT_ID,
+        IN_INT_ID,
+        IN_STRING_ID,
+        OUT_STRING_ID,
+        SUBSTR_ID,
+        LENGTH_ID,
+        CONCAT_ID,
+        ARG_ID,
+        ARG2_ID,
+        VAL_ID,
+        STR_FIELD_ID,
+        MAIN_METHOD_ID,
+        PREDEFINED_COUNT
+    };
+
+    extern const char* const PREDEFINED_SPELLINGS[PREDEFINED_COUNT];
+
+    constexpr Symbol OBJECT(OBJECT_ID);
+    constexpr Symbol INTEGER(INTEGER_ID);
+    constexpr Symbol BOOLEAN(BOOLEAN_ID);
+    constexpr Symbol STRING(STRING_ID);
+    constexpr Symbol IO(IO_ID);
+    constexpr Symbol SELF(SELF_ID);
+    constexpr Symbol SELF_TYPE(SELF_TYPE_ID);
+    constexpr Symbol NOCLASS(NOCLASS_ID);
+    constexpr Symbol NOTYPE(NOTYPE_ID);
+    constexpr Symbol PRIM_SLOT(PRIM_SLOT_ID);
+    constexpr Symbol ABORT(ABORT_ID);
+    constexpr Symbol TYPE_NAME(TYPE_NAME_ID);
+    constexpr Symbol COPY(COPY_ID);
+    constexpr Symbol MAIN(MAIN_ID);
+    constexpr Symbol OUT_INT(OUT_INT_ID);
+    constexpr Symbol IN_INT(IN_INT_ID);
+    constexpr Symbol IN_STRING(IN_STRING_ID);
+    constexpr Symbol OUT_STRING(OUT_STRING_ID);
+    constexpr Symbol SUBSTR(SUBSTR_ID);
+    constexpr Symbol LENGTH(LENGTH_ID);
+    constexpr Symbol CONCAT(CONCAT_ID);
+    constexpr Symbol ARG(ARG_ID);
+    constexpr Symbol ARG2(ARG2_ID);
+    constexpr Symbol VAL(VAL_ID);
+    constexpr Symbol STR_FIELD(STR_FIELD_ID);
+    constexpr Symbol MAIN_METHOD(MAIN_METHOD_ID);
 }
 
 #endif
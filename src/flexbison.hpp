@@ -4,29 +4,63 @@
 #undef YYSTYPE
 #define YYSTYPE ParserType
 
+// Both are copied with memcpy when the parser grows its stacks. Bison
+// only grows them in C++ if it's told so, otherwise a method body nested a
+// couple of hundred expressions deep overflows the first YYINITDEPTH entries
+#define YYSTYPE_IS_TRIVIAL 1
+#define YYLTYPE_IS_TRIVIAL 1
+
 #include "ast.hpp"
+#include "sourcebuffer.hpp"
+
+#include <string>
+#include <type_traits>
 
+// Semantic value of a token or grammar symbol. Bison copies it on every shift
+// and reduce so it's kept to a few words: nodes are pointers into the
+// AstArena and lists are arena allocated vectors that rules append to in
+// place and the rule building the owning node moves from
 class ParserType
 {
 public:
-    bool boolean;
     Symbol symbol;
-    ProgramPtr program;
-    ClassPtr clazz;
-    Classes classes;
-    AttributePtr attribute;
-    Attributes attributes;
-    MethodPtr method;
-    Methods methods;
-    FormalPtr formal;
-    Formals formals;
-    CaseBranchPtr branch;
-    Cases cases;
-    ExpressionPtr expression;
-    Expressions expressions;
-    std::string error_msg;
-
-    ParserType() {}
+
+    union
+    {
+        bool boolean;
+        ProgramPtr program;
+        ClassPtr clazz;
+        Classes* classes;
+        AttributePtr attribute;
+        Attributes* attributes;
+        MethodPtr method;
+        Methods* methods;
+        FormalPtr formal;
+        Formals* formals;
+        CaseBranchPtr branch;
+        Cases* cases;
+        ExpressionPtr expression;
+        Expressions* expressions;
+    };
+
+    ParserType()
+        : program(nullptr)
+    {
+
+    }
 };
 
+static_assert(std::is_trivially_copyable<ParserType>::value, "the parser stack is moved with memcpy");
+
+class ParseContext;
+
+// entry points of the reentrant flex scanner, defined in cool.l. A scanner
+// is an opaque handle that reads from one SourceBuffer at a time, starting
+// at the given line number
+void* flex_create(ParseContext&);
+void flex_destroy(void*);
+void flex_scan(void*, SourceBuffer&, int);
+int flex_lex(ParserType*, void*);
+int flex_lineno(void*);
+
 #endif
@@ -0,0 +1,637 @@
+#include "handlexer.hpp"
+#include "flexbison.hpp"
+#include "tokentable.hpp"
+#include "cool.tab.hh"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    struct Keyword
+    {
+        const char* spelling; // in lower case
+        std::size_t len;
+        int token;
+    };
+
+    // Keywords are matched case insensitively, so they are hashed on their
+    // length and their folded first and last characters. The multipliers were
+    // picked so that no two keywords share a slot
+    const std::size_t KEYWORD_SLOTS = 32;
+
+    inline std::size_t keyword_hash(const char* s, std::size_t len)
+    {
+        return (len + 8 * (s[0] | 0x20) + 5 * (s[len - 1] | 0x20)) & (KEYWORD_SLOTS - 1);
+    }
+
+    class KeywordTable
+    {
+    private:
+        Keyword slots[KEYWORD_SLOTS];
+
+    public:
+        KeywordTable()
+        {
+            static const Keyword keywords[] = {
+                { "class", 5, CLASS }, { "else", 4, ELSE }, { "fi", 2, FI },
+                { "if", 2, IF }, { "in", 2, IN }, { "inherits", 8, INHERITS },
+                { "let", 3, LET }, { "loop", 4, LOOP }, { "pool", 4, POOL },
+                { "then", 4, THEN }, { "while", 5, WHILE }, { "case", 4, CASE },
+                { "esac", 4, ESAC }, { "of", 2, OF }, { "new", 3, NEW },
+                { "isvoid", 6, ISVOID }, { "not", 3, NOT },
+                { "true", 4, BOOL_CONST }, { "false", 5, BOOL_CONST }
+            };
+
+            for (auto& slot : slots)
+                slot = Keyword { "", 0, 0 };
+
+            for (auto& kw : keywords)
+                slots[keyword_hash(kw.spelling, kw.len)] = kw;
+        }
+
+        // returns the keyword spelled by the word, if any. The word
+        // consists of letters, digits and underscores only
+        const Keyword* find(const char* s, std::size_t len) const
+        {
+            if (len < 2 || len > 8)
+                return nullptr;
+
+            const Keyword& kw = slots[keyword_hash(s, len)];
+            if (kw.len != len)
+                return nullptr;
+
+            // folding a digit or underscore never yields a letter
+            for (std::size_t i = 0; i < len; ++i)
+            {
+                if ((s[i] | 0x20) != kw.spelling[i])
+                    return nullptr;
+            }
+
+            return &kw;
+        }
+    };
+
+    const KeywordTable& keywords()
+    {
+        static KeywordTable table;
+        return table;
+    }
+
+    inline bool is_space(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    inline bool is_digit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    inline bool is_ident(char c)
+    {
+        return is_digit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_';
+    }
+
+    // Each of the following returns the first position in [p, end) that
+    // stops the run being scanned. Whole blocks are tested with SSE2 first,
+    // the tail of the source is done a character at a time
+
+#ifdef __SSE2__
+    inline __m128i load(const char* p)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    inline __m128i between(__m128i x, char lo, char hi)
+    {
+        return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(lo - 1)),
+                _mm_cmplt_epi8(x, _mm_set1_epi8(hi + 1)));
+    }
+#endif
+
+    // skips whitespace, adding the newlines in it to lines
+    const char* skip_space(const char* p, const char* end, int& lines)
+    {
+#ifdef __SSE2__
+        while (end - p >= 16)
+        {
+            __m128i x = load(p);
+            __m128i nl = _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'));
+            __m128i space = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                    between(x, '\t', '\r'));
+            unsigned nl_mask = _mm_movemask_epi8(nl);
+            unsigned stop_mask = ~_mm_movemask_epi8(space) & 0xffff;
+
+            if (stop_mask)
+            {
+                unsigned n = __builtin_ctz(stop_mask);
+                lines += __builtin_popcount(nl_mask & ((1u << n) - 1));
+                return p + n;
+            }
+
+            lines += __builtin_popcount(nl_mask);
+            p += 16;
+        }
+#endif
+        for (; p != end && is_space(*p); ++p)
+        {
+            if (*p == '\n')
+                ++lines;
+        }
+
+        return p;
+    }
+
+    // finds the next character that may open or close a comment, adding
+    // the newlines skipped to lines
+    const char* find_comment_delim(const char* p, const char* end, int& lines)
+    {
+#ifdef __SSE2__
+        while (end - p >= 16)
+        {
+            __m128i x = load(p);
+            unsigned nl_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+            unsigned stop_mask = _mm_movemask_epi8(_mm_or_si128(
+                        _mm_cmpeq_epi8(x, _mm_set1_epi8('(')),
+                        _mm_cmpeq_epi8(x, _mm_set1_epi8('*'))));
+
+            if (stop_mask)
+            {
+                unsigned n = __builtin_ctz(stop_mask);
+                lines += __builtin_popcount(nl_mask & ((1u << n) - 1));
+                return p + n;
+            }
+
+            lines += __builtin_popcount(nl_mask);
+            p += 16;
+        }
+#endif
+        for (; p != end && *p != '(' && *p != '*'; ++p)
+        {
+            if (*p == '\n')
+                ++lines;
+        }
+
+        return p;
+    }
+
+    // finds the next character that ends a run of plain string characters
+    const char* find_string_delim(const char* p, const char* end)
+    {
+#ifdef __SSE2__
+        while (end - p >= 16)
+        {
+            __m128i x = load(p);
+            unsigned stop_mask = _mm_movemask_epi8(_mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('"')),
+                            _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')),
+                            _mm_cmpeq_epi8(x, _mm_setzero_si128()))));
+
+            if (stop_mask)
+                return p + __builtin_ctz(stop_mask);
+
+            p += 16;
+        }
+#endif
+        for (; p != end && *p != '"' && *p != '\\' && *p != '\n' && *p != '\0'; ++p)
+            ;
+
+        return p;
+    }
+
+    // finds the next character that may open or close a block, a string or
+    // a comment, adding the newlines skipped to lines
+    const char* find_block_delim(const char* p, const char* end, int& lines)
+    {
+#ifdef __SSE2__
+        while (end - p >= 16)
+        {
+            __m128i x = load(p);
+            unsigned nl_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+            unsigned stop_mask = _mm_movemask_epi8(_mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('{')),
+                            _mm_cmpeq_epi8(x, _mm_set1_epi8('}'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('"')),
+                            _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('(')),
+                                _mm_cmpeq_epi8(x, _mm_set1_epi8('-'))))));
+
+            if (stop_mask)
+            {
+                unsigned n = __builtin_ctz(stop_mask);
+                lines += __builtin_popcount(nl_mask & ((1u << n) - 1));
+                return p + n;
+            }
+
+            lines += __builtin_popcount(nl_mask);
+            p += 16;
+        }
+#endif
+        for (; p != end && *p != '{' && *p != '}' && *p != '"' && *p != '(' && *p != '-'; ++p)
+        {
+            if (*p == '\n')
+                ++lines;
+        }
+
+        return p;
+    }
+
+    // skips the letters, digits and underscores of an identifier
+    const char* skip_ident(const char* p, const char* end)
+    {
+#ifdef __SSE2__
+        while (end - p >= 16)
+        {
+            __m128i x = load(p);
+            __m128i ident = _mm_or_si128(
+                    _mm_or_si128(between(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z'),
+                        between(x, '0', '9')),
+                    _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+            unsigned stop_mask = ~_mm_movemask_epi8(ident) & 0xffff;
+
+            if (stop_mask)
+                return p + __builtin_ctz(stop_mask);
+
+            p += 16;
+        }
+#endif
+        for (; p != end && is_ident(*p); ++p)
+            ;
+
+        return p;
+    }
+
+    // skips the digits of an integer
+    const char* skip_digits(const char* p, const char* end)
+    {
+#ifdef __SSE2__
+        while (end - p >= 16)
+        {
+            unsigned stop_mask = ~_mm_movemask_epi8(between(load(p), '0', '9')) & 0xffff;
+
+            if (stop_mask)
+                return p + __builtin_ctz(stop_mask);
+
+            p += 16;
+        }
+#endif
+        for (; p != end && is_digit(*p); ++p)
+            ;
+
+        return p;
+    }
+}
+
+HandLexer::HandLexer(LocalTokens& lexer_tokens)
+    : tokens(lexer_tokens), cur(nullptr), end(nullptr), line(1), in_bad_string(false)
+{
+
+}
+
+void HandLexer::scan(SourceBuffer& src, int first_line)
+{
+    cur = src.data();
+    end = cur + src.size();
+    in_bad_string = false;
+    line = first_line;
+}
+
+int HandLexer::lex(ParserType& val, std::string& error_msg)
+{
+    if (in_bad_string)
+    {
+        in_bad_string = false;
+        skip_bad_string();
+    }
+
+    for (;;)
+    {
+        cur = skip_space(cur, end, line);
+        if (cur == end)
+            return 0;
+
+        const char* start = cur++;
+        char next = cur != end ? *cur : '\0';
+        int token;
+
+        switch (*start)
+        {
+            case '(':
+                if (next != '*')
+                {
+                    token = '(';
+                    break;
+                }
+
+                ++cur;
+                if (skip_comment())
+                    continue;
+
+                error_msg = "EOF in comment";
+                token = ERROR;
+                break;
+
+            case '*':
+                if (next != ')')
+                {
+                    token = '*';
+                    break;
+                }
+
+                ++cur;
+                error_msg = "Unmatched *)";
+                token = ERROR;
+                break;
+
+            case '-':
+                if (next != '-')
+                {
+                    token = '-';
+                    break;
+                }
+
+                // line comment, up to and including the newline
+                cur = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+                if (cur)
+                {
+                    ++cur;
+                    ++line;
+                }
+                else
+                {
+                    cur = end;
+                }
+                continue;
+
+            case '=':
+                if (next == '>')
+                {
+                    ++cur;
+                    token = DARROW;
+                }
+                else
+                {
+                    token = '=';
+                }
+                break;
+
+            case '<':
+                if (next == '=')
+                {
+                    ++cur;
+                    token = LE;
+                }
+                else if (next == '-')
+                {
+                    ++cur;
+                    token = ASSIGN;
+                }
+                else
+                {
+                    token = '<';
+                }
+                break;
+
+            case ';': case ',': case '{': case '}': case ':': case ')':
+            case '+': case '/': case '~': case '.': case '@':
+                token = *start;
+                break;
+
+            case '"':
+                token = lex_string(val, error_msg);
+                break;
+
+            default:
+                if (is_digit(*start))
+                {
+                    cur = skip_digits(cur, end);
+                    val.symbol = tokens.ints.add(boost::string_view(start, cur - start));
+                    token = INT_CONST;
+                }
+                else if (is_ident(*start) && *start != '_')
+                {
+                    token = lex_word(start, val);
+                }
+                else
+                {
+                    error_msg = std::string(1, *start) + " is not a valid character in the current context.";
+                    token = ERROR;
+                }
+        }
+
+        return token;
+    }
+}
+
+// skips the body of a comment whose opening (* was just read, returns false
+// if the source ends first
+bool HandLexer::skip_comment()
+{
+    int depth = 1;
+
+    for (;;)
+    {
+        cur = find_comment_delim(cur, end, line);
+        if (cur == end)
+            return false;
+
+        char delim = *cur++;
+        if (cur == end)
+            return false;
+
+        if (delim == '(' && *cur == '*')
+        {
+            ++cur;
+            ++depth;
+        }
+        else if (delim == '*' && *cur == ')')
+        {
+            ++cur;
+            if (--depth == 0)
+                return true;
+        }
+    }
+}
+
+// skips what's left of a string constant after a NUL, up to the closing
+// quote or an unescaped newline
+void HandLexer::skip_bad_string()
+{
+    for (;;)
+    {
+        cur = find_string_delim(cur, end);
+        if (cur == end)
+            return;
+
+        switch (*cur++)
+        {
+            case '"':
+                return;
+
+            case '\n':
+                ++line;
+                return;
+
+            case '\\':
+                if (cur != end)
+                {
+                    if (*cur == '\n')
+                        ++line;
+                    ++cur;
+                }
+                break;
+        }
+    }
+}
+
+boost::string_view HandLexer::skip_block()
+{
+    const char* start = cur;
+    int start_line = line;
+    int depth = 1;
+
+    for (;;)
+    {
+        cur = find_block_delim(cur, end, line);
+        if (cur == end)
+            break;
+
+        char delim = *cur++;
+        char next = cur != end ? *cur : '\0';
+
+        if (delim == '{')
+        {
+            ++depth;
+        }
+        else if (delim == '}')
+        {
+            if (--depth == 0)
+            {
+                --cur;
+                return boost::string_view(start, cur + 1 - start);
+            }
+        }
+        else if (delim == '"')
+        {
+            // a string ends where the lexer ends it, also at a NUL or an
+            // unescaped newline, neither of which can hide a brace
+            skip_bad_string();
+        }
+        else if (delim == '(' && next == '*')
+        {
+            ++cur;
+            if (!skip_comment())
+                break;
+        }
+        else if (delim == '-' && next == '-')
+        {
+            cur = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+            if (!cur)
+                break;
+        }
+    }
+
+    cur = start;
+    line = start_line;
+    return boost::string_view();
+}
+
+// reads a string constant whose opening quote was just read
+int HandLexer::lex_string(ParserType& val, std::string& error_msg)
+{
+    string_buf.clear();
+
+    for (;;)
+    {
+        const char* stop = find_string_delim(cur, end);
+        string_buf.append(cur, stop - cur);
+        cur = stop;
+
+        if (cur == end)
+        {
+            error_msg = "EOF in string constant";
+            return ERROR;
+        }
+
+        char c = *cur++;
+
+        if (c == '\\')
+        {
+            if (cur == end)
+            {
+                error_msg = "EOF in string constant";
+                return ERROR;
+            }
+
+            c = *cur++;
+            switch (c)
+            {
+                case 'b':
+                    string_buf += '\b';
+                    break;
+                case 't':
+                    string_buf += '\t';
+                    break;
+                case 'n':
+                    string_buf += '\n';
+                    break;
+                case 'f':
+                    string_buf += '\f';
+                    break;
+                case '\n':
+                    ++line;
+                    string_buf += '\n';
+                    break;
+                case '\0':
+                    in_bad_string = true;
+                    error_msg = "String contains null character";
+                    return ERROR;
+                default:
+                    string_buf += c;
+            }
+        }
+        else if (c == '"')
+        {
+            val.symbol = tokens.strings.add(string_buf);
+            return STR_CONST;
+        }
+        else if (c == '\n')
+        {
+            ++line;
+            error_msg = "Unterminated string constant";
+            return ERROR;
+        }
+        else
+        {
+            in_bad_string = true;
+            error_msg = "String contains null character";
+            return ERROR;
+        }
+    }
+}
+
+// reads a keyword, boolean constant or identifier starting with a letter
+int HandLexer::lex_word(const char* start, ParserType& val)
+{
+    cur = skip_ident(cur, end);
+
+    std::size_t len = cur - start;
+    const Keyword* kw = keywords().find(start, len);
+
+    if (kw && kw->token != BOOL_CONST)
+        return kw->token;
+
+    // the first letter of true and false has to be lower case
+    if (kw && *start == kw->spelling[0])
+    {
+        val.boolean = (kw->len == 4);
+        return BOOL_CONST;
+    }
+
+    val.symbol = tokens.ids.add(boost::string_view(start, len));
+    return (*start >= 'A' && *start <= 'Z') ? TYPEID : OBJECTID;
+}
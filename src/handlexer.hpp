@@ -0,0 +1,60 @@
+// Hand written scanner for COOL, an alternative to the flex scanner in cool.l
+// that produces the same tokens: codes from cool.tab.hh, values in a
+// ParserType, and a message for every ERROR token. It scans the SourceBuffer
+// in place, skips whitespace, comment bodies and string runs 16 bytes at a
+// time with SSE2 where available, and classifies keywords with a perfect hash
+// instead of a DFA.
+
+#ifndef HANDLEXER_H
+#define HANDLEXER_H
+
+#include "sourcebuffer.hpp"
+#include "tokentable.hpp"
+
+#include <boost/utility/string_view.hpp>
+
+#include <string>
+
+class ParserType;
+
+class HandLexer
+{
+private:
+    LocalTokens& tokens; // where identifiers and constants are interned
+    const char* cur;
+    const char* end;
+    int line; // line of the last character read
+    bool in_bad_string; // an ERROR was returned for a NUL, the rest of the string is still to be skipped
+    std::string string_buf; // buffer to build string constants in, grows as needed
+
+    bool skip_comment();
+    void skip_bad_string();
+    int lex_string(ParserType&, std::string&);
+    int lex_word(const char*, ParserType&);
+
+public:
+    explicit HandLexer(LocalTokens&);
+
+    // start scanning the source, numbering its first line first_line. The
+    // source must stay alive until the last token is returned
+    void scan(SourceBuffer&, int first_line = 1);
+
+    // Returns the next token, 0 at the end of the source. The value of
+    // constants and identifiers is stored in val, the message of an ERROR
+    // token in error_msg
+    int lex(ParserType& val, std::string& error_msg);
+
+    // Skips a method body whose opening '{' was the last token returned, up
+    // to the matching '}' which is left to be read by the next lex. Returns
+    // the body including that '}', or an empty view if there is no matching
+    // '}' and nothing was skipped. The body isn't lexed, so errors in it go
+    // unnoticed until it is parsed
+    boost::string_view skip_block();
+
+    int get_line() const
+    {
+        return line;
+    }
+};
+
+#endif
@@ -0,0 +1,739 @@
+#include "handparser.hpp"
+#include "parsecontext.hpp"
+#include "constants.hpp"
+#include "cool.tab.hh"
+
+#include <utility>
+
+namespace
+{
+    // Precedence levels of cool.yc, higher binds tighter. An operator
+    // continues an expression if its level is above the level of the
+    // construct the expression is the last part of
+    enum Precedence
+    {
+        PREC_NONE,
+        PREC_EQUAL, // nonassoc
+        PREC_LET,
+        PREC_ASSIGN,
+        PREC_NOT,
+        PREC_ADD,
+        PREC_MUL,
+        PREC_ISVOID,
+        PREC_COMPLEMENT,
+        PREC_AT,
+        PREC_DOT,
+        PREC_COMPARE // nonassoc
+    };
+
+    // level of the tokens that can follow an expression to extend it
+    Precedence infix_prec(int token)
+    {
+        switch (token)
+        {
+            case '=': return PREC_EQUAL;
+            case '+': case '-': return PREC_ADD;
+            case '*': case '/': return PREC_MUL;
+            case '@': return PREC_AT;
+            case '.': return PREC_DOT;
+            case '<': case LE: return PREC_COMPARE;
+            default: return PREC_NONE;
+        }
+    }
+}
+
+HandParser::HandParser(ParseContext& context)
+    : ctx(context), token(0), line(0), aborted(false), error_status(0)
+{
+
+}
+
+// reads the next token without shifting the lookahead
+void HandParser::advance()
+{
+    token = ctx.lex(val);
+    line = ctx.line();
+    ctx.last_token = token;
+    ctx.last_val = val;
+}
+
+// shifts the lookahead and reads the next token
+void HandParser::next()
+{
+    if (error_status > 0)
+        --error_status;
+
+    advance();
+}
+
+// a construct that catches errors was completed, errors are reported again
+// right away, like yyerrok in cool.yc
+void HandParser::resume()
+{
+    error_status = 0;
+}
+
+bool HandParser::expect(int tok)
+{
+    if (token != tok)
+    {
+        error();
+        return false;
+    }
+
+    next();
+    return true;
+}
+
+// expects a token with a symbol value and returns the symbol and its line
+bool HandParser::expect(int tok, Symbol& sym, int& sym_line)
+{
+    if (token != tok)
+    {
+        error();
+        return false;
+    }
+
+    sym = val.symbol;
+    sym_line = line;
+    next();
+    return true;
+}
+
+void HandParser::error()
+{
+    if (error_status == 0)
+        ctx.syntax_error();
+}
+
+// Skips tokens up to and including sync, after a construct that catches
+// errors failed. Returns false if the source ends first
+bool HandParser::recover(int sync)
+{
+    if (aborted)
+        return false;
+
+    error_status = 3;
+
+    while (token != sync)
+    {
+        if (token == 0)
+        {
+            aborted = true;
+            return false;
+        }
+
+        advance();
+    }
+
+    next();
+    return true;
+}
+
+template<typename T, typename... Args>
+T* HandParser::make(int loc_line, Args&&... args)
+{
+    T* node = ctx.arena.make<T>(std::forward<Args>(args)...);
+    node->setloc(ctx.location(loc_line));
+    return node;
+}
+
+void HandParser::parse()
+{
+    Classes classes;
+
+    advance();
+
+    // an error outside of a class body skips to the next ';'
+    do
+    {
+        ClassPtr cls = nullptr;
+
+        if (token == CLASS)
+            cls = parse_class();
+        else
+            error();
+
+        if (cls)
+            classes.push_back(cls);
+        else if (recover(';'))
+            resume();
+        else
+            return;
+    } while (token != 0);
+
+    ctx.program = ctx.arena.make<Program>(std::move(classes));
+}
+
+ExpressionPtr HandParser::parse_body()
+{
+    advance();
+
+    Expr body = parse_expr(PREC_NONE);
+    if (!body.node || !expect('}'))
+        return nullptr;
+
+    // the source ends with the '}'
+    return body.node;
+}
+
+ClassPtr HandParser::parse_class()
+{
+    // where an error in the body skips to the next ';'
+    enum Body
+    {
+        NO_FEATURES, // continues with the attributes
+        ATTRIBUTES, // continues with more attributes or the methods
+        METHODS // continues with more methods or the end of the class
+    };
+
+    int class_line = line;
+    Symbol name;
+    Symbol parent = constants::OBJECT;
+    int name_line;
+
+    next();
+    if (!expect(TYPEID, name, name_line))
+        return nullptr;
+
+    if (token == INHERITS)
+    {
+        next();
+        if (!expect(TYPEID, parent, name_line))
+            return nullptr;
+    }
+
+    if (!expect('{'))
+        return nullptr;
+
+    Attributes attributes;
+    Methods methods;
+    Body body = NO_FEATURES;
+
+    for (;;)
+    {
+        bool ok = false;
+
+        if (body == METHODS && token == '}')
+        {
+            next();
+            if (expect(';'))
+                break;
+        }
+        else if (token != OBJECTID)
+        {
+            error();
+        }
+        else
+        {
+            Symbol feature = val.symbol;
+            int feature_line = line;
+            next();
+
+            if (token == ':' && body != METHODS)
+            {
+                ok = parse_attribute(feature, feature_line, attributes);
+                if (ok)
+                    body = ATTRIBUTES;
+            }
+            else if (token == '(' && body != NO_FEATURES)
+            {
+                ok = parse_method(feature, feature_line, methods);
+                if (ok)
+                    body = METHODS;
+            }
+            else
+            {
+                error();
+            }
+        }
+
+        if (!ok)
+        {
+            if (!recover(';'))
+                return nullptr;
+
+            resume();
+
+            // the Bison parser resumes after an error as if the features up
+            // to the ';' were an attribute when there were none yet, and a
+            // method otherwise
+            body = body == NO_FEATURES ? ATTRIBUTES : METHODS;
+        }
+    }
+
+    return make<Class>(class_line, name, parent, std::move(attributes), std::move(methods));
+}
+
+bool HandParser::parse_attribute(const Symbol& name, int name_line, Attributes& attributes)
+{
+    Symbol type;
+    int type_line;
+
+    next();
+    if (!expect(TYPEID, type, type_line))
+        return false;
+
+    AttributePtr attr;
+
+    if (token == ASSIGN)
+    {
+        next();
+        Expr init = parse_expr(PREC_NONE);
+        if (!init.node)
+            return false;
+
+        attr = make<Attribute>(init.line, name, type, init.node);
+    }
+    else
+    {
+        attr = make<Attribute>(name_line, name, type, ctx.arena.make<NoExpr>());
+    }
+
+    if (!expect(';'))
+        return false;
+
+    attributes.push_back(attr);
+    return true;
+}
+
+bool HandParser::parse_method(const Symbol& name, int name_line, Methods& methods)
+{
+    Formals formals;
+    Symbol type;
+    int type_line;
+
+    next();
+    if (token != ')')
+    {
+        for (;;)
+        {
+            Symbol formal;
+            int formal_line;
+
+            if (!expect(OBJECTID, formal, formal_line) || !expect(':') ||
+                    !expect(TYPEID, type, type_line))
+                return false;
+
+            formals.push_back(make<Formal>(formal_line, formal, type));
+
+            if (token != ',')
+                break;
+            next();
+        }
+    }
+
+    if (!expect(')') || !expect(':') || !expect(TYPEID, type, type_line))
+        return false;
+
+    // with lazy methods the body is kept as source until it's needed
+    const MethodSource* source = token == '{' && ctx.lazy_methods ? ctx.skip_body() : nullptr;
+    ExpressionPtr body = nullptr;
+
+    if (!expect('{'))
+        return false;
+
+    if (!source)
+    {
+        body = parse_expr(PREC_NONE).node;
+        if (!body)
+            return false;
+    }
+
+    if (!expect('}') || !expect(';'))
+        return false;
+
+    MethodPtr method = make<Method>(name_line, name, type, std::move(formals), body);
+    method->source = source;
+    methods.push_back(method);
+    return true;
+}
+
+// parses the arguments of a dispatch, after the '('
+bool HandParser::parse_args(Expressions& args)
+{
+    if (token != ')')
+    {
+        for (;;)
+        {
+            Expr arg = parse_expr(PREC_NONE);
+            if (!arg.node)
+                return false;
+
+            args.push_back(arg.node);
+
+            if (token != ',')
+                break;
+            next();
+        }
+    }
+
+    return expect(')');
+}
+
+// Parses an expression that is the last part of a construct of the given
+// level, i.e. one that stops at the first operator of the same level or lower
+HandParser::Expr HandParser::parse_expr(int level)
+{
+    Expr expr = parse_prefix();
+
+    while (expr.node)
+    {
+        int prec = infix_prec(token);
+
+        if (prec == PREC_NONE || prec < level)
+            break;
+
+        if (prec == level)
+        {
+            // a = b = c and a < b < c are errors, a + b + c groups left
+            if (level == PREC_EQUAL || level == PREC_COMPARE)
+            {
+                error();
+                expr.node = nullptr;
+            }
+
+            break;
+        }
+
+        expr = parse_infix(expr);
+    }
+
+    return expr;
+}
+
+HandParser::Expr HandParser::parse_prefix()
+{
+    Expr expr { nullptr, line };
+
+    switch (token)
+    {
+        case OBJECTID:
+        {
+            Symbol name = val.symbol;
+            next();
+
+            if (token == ASSIGN)
+            {
+                next();
+                Expr rhs = parse_expr(PREC_ASSIGN);
+                if (rhs.node)
+                    expr.node = make<Assign>(rhs.line, name, rhs.node);
+            }
+            else if (token == '(')
+            {
+                Expressions args;
+                next();
+                if (parse_args(args))
+                    expr.node = make<DynamicDispatch>(expr.line, ctx.arena.make<Object>(constants::SELF),
+                            name, std::move(args));
+            }
+            else
+            {
+                expr.node = make<Object>(expr.line, name);
+            }
+            break;
+        }
+        case INT_CONST:
+            expr.node = ctx.add_int(val.symbol);
+            expr.node->setloc(ctx.location(line));
+            next();
+            break;
+        case STR_CONST:
+            expr.node = ctx.add_string(val.symbol);
+            expr.node->setloc(ctx.location(line));
+            next();
+            break;
+        case BOOL_CONST:
+            expr.node = make<BoolConst>(line, val.boolean);
+            next();
+            break;
+        case IF:
+        {
+            next();
+            Expr pred = parse_expr(PREC_NONE);
+            if (!pred.node || !expect(THEN))
+                break;
+
+            Expr iftrue = parse_expr(PREC_NONE);
+            if (!iftrue.node || !expect(ELSE))
+                break;
+
+            Expr iffalse = parse_expr(PREC_NONE);
+            if (!iffalse.node || !expect(FI))
+                break;
+
+            expr.node = make<If>(pred.line, pred.node, iftrue.node, iffalse.node);
+            break;
+        }
+        case WHILE:
+        {
+            next();
+            Expr pred = parse_expr(PREC_NONE);
+            if (!pred.node || !expect(LOOP))
+                break;
+
+            Expr body = parse_expr(PREC_NONE);
+            if (!body.node || !expect(POOL))
+                break;
+
+            expr.node = make<While>(pred.line, pred.node, body.node);
+            break;
+        }
+        case '{':
+            next();
+            expr.node = parse_block().node;
+            break;
+        case LET:
+        {
+            next();
+            Expr let = parse_let();
+            if (let.node)
+            {
+                let.node->setloc(ctx.location(let.line));
+                expr.node = let.node;
+            }
+            break;
+        }
+        case CASE:
+            next();
+            expr.node = parse_case().node;
+            break;
+        case NEW:
+        {
+            Symbol type;
+            int type_line;
+
+            next();
+            if (expect(TYPEID, type, type_line))
+                expr.node = make<New>(type_line, type);
+            break;
+        }
+        case ISVOID:
+        {
+            next();
+            Expr sub = parse_expr(PREC_ISVOID);
+            if (sub.node)
+                expr.node = make<IsVoid>(sub.line, sub.node);
+            break;
+        }
+        case '~':
+        {
+            next();
+            Expr sub = parse_expr(PREC_COMPLEMENT);
+            if (sub.node)
+                expr.node = make<Complement>(sub.line, sub.node);
+            break;
+        }
+        case NOT:
+        {
+            next();
+            Expr sub = parse_expr(PREC_NOT);
+            if (sub.node)
+                expr.node = make<Not>(sub.line, sub.node);
+            break;
+        }
+        case '(':
+        {
+            next();
+            Expr sub = parse_expr(PREC_NONE);
+            if (sub.node && expect(')'))
+            {
+                sub.node->setloc(ctx.location(sub.line));
+                expr.node = sub.node;
+            }
+            break;
+        }
+        default:
+            error();
+    }
+
+    return expr;
+}
+
+// parses the operator after lhs and what follows it
+HandParser::Expr HandParser::parse_infix(const Expr& lhs)
+{
+    Expr expr { nullptr, lhs.line };
+    int op = token;
+
+    next();
+
+    if (op == '.' || op == '@')
+    {
+        Symbol type;
+        Symbol method;
+        int sym_line;
+        Expressions args;
+
+        if (op == '@' && (!expect(TYPEID, type, sym_line) || !expect('.')))
+            return expr;
+
+        if (!expect(OBJECTID, method, sym_line) || !expect('(') || !parse_args(args))
+            return expr;
+
+        if (op == '.')
+            expr.node = make<DynamicDispatch>(lhs.line, lhs.node, method, std::move(args));
+        else
+            expr.node = make<StaticDispatch>(lhs.line, lhs.node, type, method, std::move(args));
+
+        return expr;
+    }
+
+    Expr rhs = parse_expr(infix_prec(op));
+    if (!rhs.node)
+        return expr;
+
+    switch (op)
+    {
+        case '+': expr.node = make<Plus>(lhs.line, lhs.node, rhs.node); break;
+        case '-': expr.node = make<Sub>(lhs.line, lhs.node, rhs.node); break;
+        case '*': expr.node = make<Mul>(lhs.line, lhs.node, rhs.node); break;
+        case '/': expr.node = make<Div>(lhs.line, lhs.node, rhs.node); break;
+        case '<': expr.node = make<LessThan>(lhs.line, lhs.node, rhs.node); break;
+        case LE: expr.node = make<LessThanEqualTo>(lhs.line, lhs.node, rhs.node); break;
+        case '=': expr.node = make<EqualTo>(lhs.line, lhs.node, rhs.node); break;
+    }
+
+    return expr;
+}
+
+// Parses the bindings and body of a let, after the let or a ','. An error
+// skips to the next ',', where the bindings start over
+HandParser::Expr HandParser::parse_let()
+{
+    Expr expr { nullptr, line };
+    Symbol name;
+    Symbol type;
+    int sym_line;
+
+    if (expect(OBJECTID, name, sym_line) && expect(':') && expect(TYPEID, type, sym_line))
+    {
+        ExpressionPtr init = nullptr;
+        int init_line = 0;
+        int assign_line = line;
+
+        if (token == ASSIGN)
+        {
+            next();
+            Expr e = parse_expr(PREC_NONE);
+            init = e.node;
+            init_line = e.line;
+        }
+        else
+        {
+            init = ctx.arena.make<NoExpr>();
+        }
+
+        if (init && token == IN)
+        {
+            next();
+            Expr body = parse_expr(PREC_LET);
+            if (body.node)
+            {
+                // with an initializer, the let is placed on its first line
+                int loc_line = init_line > 0 ? init_line : body.line;
+                expr.node = make<Let>(loc_line, name, type, init, body.node);
+            }
+        }
+        else if (init && token == ',')
+        {
+            next();
+            Expr rest = parse_let();
+            if (!rest.node)
+                return rest;
+
+            int loc_line = init_line > 0 ? assign_line : rest.line;
+            expr.node = make<Let>(loc_line, name, type, init, rest.node);
+        }
+        else if (init)
+        {
+            error();
+        }
+    }
+
+    if (!expr.node)
+    {
+        if (!recover(','))
+            return expr;
+
+        // the bindings after the ',' have to be complete before errors are
+        // reported again
+        Expr rest = parse_let();
+        if (rest.node)
+            resume();
+
+        return rest;
+    }
+
+    return expr;
+}
+
+// Parses the expressions of a block, after the '{'. An error skips to the
+// next ';', where the block goes on
+HandParser::Expr HandParser::parse_block()
+{
+    Expr block { nullptr, line };
+    Expressions body;
+    bool first = true;
+
+    for (;;)
+    {
+        Expr expr = parse_expr(PREC_NONE);
+
+        if (expr.node && expect(';'))
+        {
+            if (first)
+                block.line = expr.line;
+
+            body.push_back(expr.node);
+        }
+        else if (recover(';'))
+        {
+            resume();
+        }
+        else
+        {
+            return block;
+        }
+
+        first = false;
+
+        if (token == '}')
+            break;
+    }
+
+    next();
+    block.node = make<Block>(block.line, std::move(body));
+    return block;
+}
+
+// parses the scrutinee and branches of a case, after the case
+HandParser::Expr HandParser::parse_case()
+{
+    Expr expr = parse_expr(PREC_NONE);
+    if (!expr.node || !expect(OF))
+        return Expr { nullptr, expr.line };
+
+    Cases branches;
+
+    do
+    {
+        Symbol name;
+        Symbol type;
+        int sym_line;
+
+        if (!expect(OBJECTID, name, sym_line) || !expect(':') || !expect(TYPEID, type, sym_line) ||
+                !expect(DARROW))
+            return Expr { nullptr, expr.line };
+
+        Expr branch = parse_expr(PREC_NONE);
+        if (!branch.node || !expect(';'))
+            return Expr { nullptr, expr.line };
+
+        branches.push_back(make<CaseBranch>(branch.line, name, type, branch.node));
+    } while (token != ESAC);
+
+    next();
+    return Expr { make<Case>(expr.line, expr.node, std::move(branches)), expr.line };
+}
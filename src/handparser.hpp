@@ -0,0 +1,77 @@
+// Hand written parser for COOL, an alternative to the Bison parser in
+// cool.yc. It is a recursive descent parser for classes and features, with
+// Pratt style precedence climbing for expressions, and builds the same AST
+// with the same locations as the Bison parser.
+//
+// Operator precedence follows the declarations in cool.yc, lowest first:
+// '=', let, '<-', not, '+' '-', '*' '/', isvoid, '~', '@', '.', '<=' '<'.
+// Errors are recovered from at the same places as the Bison grammar's error
+// rules: at ';' in blocks, feature lists and between classes, and at ',' in
+// let bindings. An error is caught by the innermost of those constructs that
+// is still open, so the errors reported are the same as with Bison. Like
+// Bison, errors found before three tokens were shifted since the last one
+// aren't reported, unless an error rule was completed in between.
+
+#ifndef HANDPARSER_H
+#define HANDPARSER_H
+
+#include "ast.hpp"
+#include "flexbison.hpp"
+
+class ParseContext;
+
+class HandParser
+{
+private:
+    // An expression and the line of its first token, which is where the
+    // Bison parser places nodes that span several tokens
+    class Expr
+    {
+    public:
+        ExpressionPtr node; // nullptr if the expression has errors
+        int line;
+    };
+
+    ParseContext& ctx;
+    int token; // lookahead token
+    ParserType val; // value of the lookahead token
+    int line; // line of the lookahead token
+    bool aborted; // the source ended while recovering from an error
+    int error_status; // tokens left to shift before errors are reported again
+
+    void advance();
+    void next();
+    void resume();
+    bool expect(int);
+    bool expect(int, Symbol&, int&);
+    void error();
+    bool recover(int);
+
+    template<typename T, typename... Args>
+    T* make(int loc_line, Args&&... args);
+
+    ClassPtr parse_class();
+    bool parse_attribute(const Symbol&, int, Attributes&);
+    bool parse_method(const Symbol&, int, Methods&);
+    bool parse_args(Expressions&);
+
+    Expr parse_expr(int);
+    Expr parse_prefix();
+    Expr parse_infix(const Expr&);
+    Expr parse_let();
+    Expr parse_block();
+    Expr parse_case();
+
+public:
+    explicit HandParser(ParseContext&);
+
+    // Parses the source the context is scanning and sets ctx.program,
+    // leaving it nullptr if the source ended while recovering from an error
+    void parse();
+
+    // Parses the source of a method body skipped with ctx.lazy_methods,
+    // returns nullptr if it has errors
+    ExpressionPtr parse_body();
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "lazymethods.hpp"
+#include "constants.hpp"
+#include "parsecontext.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    // Walks expressions and collects the names of the methods they dispatch
+    // to that weren't seen before
+    class DispatchCollector : public AstNodeVisitor
+    {
+    private:
+        std::unordered_set<Symbol> seen;
+
+    public:
+        std::vector<Symbol> pending; // names seen first, not yet handled
+
+        void reach(const Symbol& name)
+        {
+            if (seen.insert(name).second)
+                pending.push_back(name);
+        }
+
+        void visit(CaseBranch& branch)
+        {
+            branch.expr->accept(*this);
+        }
+
+        void visit(IsVoid& isvoid)
+        {
+            isvoid.expr->accept(*this);
+        }
+
+        void visit(Assign& assign)
+        {
+            assign.rhs->accept(*this);
+        }
+
+        void visit(Block& block)
+        {
+            for (auto& expr : block.body)
+                expr->accept(*this);
+        }
+
+        void visit(If& ifstmt)
+        {
+            ifstmt.predicate->accept(*this);
+            ifstmt.iftrue->accept(*this);
+            ifstmt.iffalse->accept(*this);
+        }
+
+        void visit(While& wstmt)
+        {
+            wstmt.predicate->accept(*this);
+            wstmt.body->accept(*this);
+        }
+
+        void visit(Complement& comp)
+        {
+            comp.expr->accept(*this);
+        }
+
+        void visit(LessThan& lt)
+        {
+            lt.lhs->accept(*this);
+            lt.rhs->accept(*this);
+        }
+
+        void visit(EqualTo& eq)
+        {
+            eq.lhs->accept(*this);
+            eq.rhs->accept(*this);
+        }
+
+        void visit(LessThanEqualTo& le)
+        {
+            le.lhs->accept(*this);
+            le.rhs->accept(*this);
+        }
+
+        void visit(Plus& plus)
+        {
+            plus.lhs->accept(*this);
+            plus.rhs->accept(*this);
+        }
+
+        void visit(Sub& sub)
+        {
+            sub.lhs->accept(*this);
+            sub.rhs->accept(*this);
+        }
+
+        void visit(Mul& mul)
+        {
+            mul.lhs->accept(*this);
+            mul.rhs->accept(*this);
+        }
+
+        void visit(Div& div)
+        {
+            div.lhs->accept(*this);
+            div.rhs->accept(*this);
+        }
+
+        void visit(Not& nt)
+        {
+            nt.expr->accept(*this);
+        }
+
+        void visit(StaticDispatch& sdisp)
+        {
+            reach(sdisp.method);
+            sdisp.obj->accept(*this);
+            for (auto& expr : sdisp.actual)
+                expr->accept(*this);
+        }
+
+        void visit(DynamicDispatch& ddisp)
+        {
+            reach(ddisp.method);
+            ddisp.obj->accept(*this);
+            for (auto& expr : ddisp.actual)
+                expr->accept(*this);
+        }
+
+        void visit(Let& let)
+        {
+            let.init->accept(*this);
+            let.body->accept(*this);
+        }
+
+        void visit(Case& caze)
+        {
+            caze.expr->accept(*this);
+            for (auto& branch : caze.branches)
+                branch->accept(*this);
+        }
+    };
+}
+
+std::size_t parse_reachable_methods(CompilerContext& compiler, const Classes& classes)
+{
+    std::unordered_map<Symbol, std::vector<MethodPtr>> methods; // by name
+    DispatchCollector collector;
+
+    // the runtime calls Main.main, and any class may be instantiated
+    collector.reach(constants::MAIN_METHOD);
+
+    for (auto& cs : classes)
+    {
+        for (auto& method : cs->methods)
+            methods[method->name].push_back(method);
+
+        for (auto& attrib : cs->attributes)
+            attrib->init->accept(collector);
+    }
+
+    ParseContext ctx(compiler, compiler.arena, HAND_LEXER, HAND_PARSER);
+    std::size_t errors = 0;
+
+    while (!collector.pending.empty())
+    {
+        Symbol name = collector.pending.back();
+        collector.pending.pop_back();
+
+        for (auto& method : methods[name])
+        {
+            if (!method->body)
+            {
+                method->body = ctx.parse_body(*method->source, compiler.sources.get_file(method->loc));
+                compiler.errors << ctx.diagnostics;
+                errors += ctx.error_count;
+
+                if (ctx.error_count == 0)
+                    compiler.constants.add_all(ctx.constants);
+            }
+
+            if (method->body)
+                method->body->accept(collector);
+        }
+    }
+
+    return errors;
+}
@@ -0,0 +1,23 @@
+// Lazy parsing of method bodies, turned on with --lazy-methods. The hand
+// parser then skips the body of every method without lexing it and keeps
+// its source in the Method node (see MethodSource in ast.hpp). Bodies are
+// parsed here, but only those of the methods the program can call: starting
+// from Main.main and the attribute initializers, a dispatch to a method name
+// reaches every method of that name, in any class. Methods that can't be
+// reached keep a nullptr body, so they are neither type checked nor compiled,
+// and syntax errors in them are never reported.
+
+#ifndef LAZYMETHODS_H
+#define LAZYMETHODS_H
+
+#include "ast.hpp"
+#include "compilercontext.hpp"
+
+#include <cstddef>
+
+// Parses the skipped bodies of the methods that can be called, allocating
+// them in the compilation's arena. Returns the number of syntax errors,
+// which are printed to the compilation's errors
+std::size_t parse_reachable_methods(CompilerContext&, const Classes&);
+
+#endif
@@ -0,0 +1,107 @@
+#include "lexbench.hpp"
+#include "parsecontext.hpp"
+#include "sourcebuffer.hpp"
+#include "utility.hpp"
+#include "cool.tab.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    struct Token
+    {
+        int code;
+        std::uint32_t val; // symbol id or boolean of constants and identifiers
+
+        bool operator==(const Token& other) const
+        {
+            return code == other.code && val == other.val;
+        }
+    };
+
+    std::vector<Token> tokenize(ParseContext& ctx, SourceBuffer& src)
+    {
+        std::vector<Token> tokens;
+        ParserType lval;
+
+        ctx.scan(src, SourceLocation::NO_FILE);
+        for (int code = ctx.lex(lval); code != 0; code = ctx.lex(lval))
+        {
+            std::uint32_t val = 0;
+
+            if (code == STR_CONST || code == INT_CONST || code == TYPEID || code == OBJECTID)
+                val = lval.symbol.get_id();
+            else if (code == BOOL_CONST)
+                val = lval.boolean;
+
+            tokens.push_back(Token { code, val });
+        }
+
+        return tokens;
+    }
+
+    // scans the source until about a second has passed, returns bytes per second
+    double measure(ParseContext& ctx, SourceBuffer& src)
+    {
+        ParserType lval;
+        typedef std::chrono::steady_clock Clock;
+
+        Clock::time_point start = Clock::now();
+        std::size_t runs = 0;
+        double secs;
+
+        do
+        {
+            ctx.scan(src, SourceLocation::NO_FILE);
+            while (ctx.lex(lval) != 0)
+                ;
+
+            ++runs;
+            secs = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (secs < 1.0);
+
+        return runs * src.size() / secs;
+    }
+}
+
+int benchmark_lexers(const std::vector<std::string>& files)
+{
+    int status = 0;
+    CompilerContext compiler(std::cerr);
+    ParseContext flex_ctx(compiler, compiler.arena, FLEX_LEXER);
+    ParseContext hand_ctx(compiler, compiler.arena, HAND_LEXER);
+
+    for (auto& file : files)
+    {
+        SourceBuffer src;
+        if (!src.load_file(file))
+        {
+            utility::print_error(file, "cannot be opened");
+            status = 1;
+            continue;
+        }
+
+        std::vector<Token> flex_tokens = tokenize(flex_ctx, src);
+        double flex_rate = measure(flex_ctx, src);
+
+        std::vector<Token> hand_tokens = tokenize(hand_ctx, src);
+        double hand_rate = measure(hand_ctx, src);
+
+        std::cout << file << ": " << src.size() << " bytes, " << flex_tokens.size() << " tokens\n"
+                  << std::fixed << std::setprecision(1)
+                  << "    flex: " << flex_rate / 1e6 << " MB/s\n"
+                  << "    hand: " << hand_rate / 1e6 << " MB/s ("
+                  << std::setprecision(2) << hand_rate / flex_rate << "x)\n";
+
+        if (flex_tokens != hand_tokens)
+        {
+            utility::print_error(file, "lexers produce different tokens");
+            status = 1;
+        }
+    }
+
+    return status;
+}
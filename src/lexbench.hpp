@@ -0,0 +1,15 @@
+// Throughput benchmark of the lexers, run as coolc --bench-lexer FILE...
+// Every file is scanned repeatedly by each lexer for about a second and the
+// rate is reported. The token streams of the lexers are compared as well,
+// so the benchmark fails if they disagree on any file.
+
+#ifndef LEXBENCH_H
+#define LEXBENCH_H
+
+#include <string>
+#include <vector>
+
+// returns the exit status, 0 if all files were read and the lexers agree
+int benchmark_lexers(const std::vector<std::string>&);
+
+#endif
@@ -1,81 +1,129 @@
-#include "symboltable.hpp"
-#include "tokentable.hpp"
-#include "ast.hpp"
-#include "semanticanalyzer.hpp"
-#include "astnodevisitor.hpp"
-#include "astnodecodegenerator.hpp"
+#include "compiler.hpp"
+#include "compilercontext.hpp"
+#include "compileserver.hpp"
+#include "lexbench.hpp"
+#include "parserbench.hpp"
+#include "threadpool.hpp"
 #include "utility.hpp"
 
-#include <cstdio>
+#include <cstdlib>
 #include <iostream>
-#include <fstream>
-
-// all defined by lexer
-extern int yyparse();
-extern int yynerrs;
-extern FILE* yyin;
-
-// Root of AST used by the parser. This should be populated
-// after parsing phase
-ProgramPtr ast_root;
-
-// Used by the error handling routines in both lexer and
-// parser to provide a more informative error message
-std::string curr_filename;
+#include <string>
+#include <vector>
 
 int main(int argc, char **argv)
 {
-    if (argc == 1)
-    {
-        curr_filename = "<stdin>";
-        yyin = stdin;
-        yyparse();
-    }
-    else
+    std::vector<std::string> files;
+    CompileOptions opts;
+    std::string manifest;
+    std::string server_socket;
+    std::string client_socket;
+    bool bench_lexer = false;
+    bool bench_parser = false;
+    std::size_t num_jobs = ThreadPool::default_size();
+
+    for (int i = 1; i < argc; ++i)
     {
-        for (int i = 1; i < argc; ++i)
-        {
-            curr_filename = argv[i];
-            yyin = std::fopen(argv[i], "r");
+        std::string arg = argv[i];
 
-            if (yyin)
+        if (arg == "--lexer=flex")
+            opts.lexer = FLEX_LEXER;
+        else if (arg == "--lexer=hand")
+            opts.lexer = HAND_LEXER;
+        else if (arg == "--parser=bison")
+            opts.parser = BISON_PARSER;
+        else if (arg == "--parser=hand")
+            opts.parser = HAND_PARSER;
+        else if (arg == "--lazy-methods")
+            opts.lazy_methods = true;
+        else if (arg == "--bench-lexer")
+            bench_lexer = true;
+        else if (arg == "--bench-parser")
+            bench_parser = true;
+        else if (arg == "--pipeline")
+            opts.pipeline = true;
+        else if (arg == "--pipeline-stats")
+            opts.pipeline = opts.pipeline_stats = true;
+        else if (arg.compare(0, 17, "--pipeline-queue=") == 0)
+        {
+            opts.pipeline = true;
+            opts.queue_size = std::strtoul(arg.c_str() + 17, nullptr, 10);
+            if (opts.queue_size == 0)
             {
-                yyparse();
-                std::fclose(yyin);
+                utility::print_error(arg, "queue size must be at least 1");
+                exit(1);
             }
-            else
+        }
+        else if (arg.compare(0, 7, "--jobs=") == 0)
+        {
+            num_jobs = std::strtoul(arg.c_str() + 7, nullptr, 10);
+            if (num_jobs == 0)
             {
-                utility::print_error(argv[i], "cannot be opened");
+                utility::print_error(arg, "number of jobs must be at least 1");
+                exit(1);
             }
         }
-    }
+        else if (arg == "--batch")
+        {
+            if (++i == argc)
+            {
+                utility::print_error(arg, "a manifest must be given");
+                exit(1);
+            }
 
-    if (yynerrs > 0)
-    {
-        std::cerr << "Compilation halted due to lexical or syntax errors.\n";
-        exit(1);
-    }
+            manifest = argv[i];
+        }
+        else if (arg == "--server" || arg == "--connect")
+        {
+            if (++i == argc)
+            {
+                utility::print_error(arg, "a socket must be given");
+                exit(1);
+            }
 
-    SemanticAnalyzer semant;
-    semant.install_basic(ast_root);
-    if (!semant.validate_inheritance(ast_root->classes))
-    {
-        std::cerr << "Compilation halted due to inheritance errors.\n";
-        exit(1);
+            if (arg == "--server")
+                server_socket = argv[i];
+            else
+                client_socket = argv[i];
+        }
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            utility::print_error(arg, "unknown option");
+            exit(1);
+        }
+        else
+            files.push_back(arg);
     }
 
-    if (!semant.type_check(ast_root))
+    // only the hand written lexer and parser can skip method bodies
+    if (opts.lazy_methods)
     {
-        std::cerr << "Compilation halted due to type errors.\n";
-        exit(1);
+        opts.lexer = HAND_LEXER;
+        opts.parser = HAND_PARSER;
     }
 
-    AstNodeDisplayer print(std::cout, AstNodeDisplayer::DISPLAYNONBASIC);
-    ast_root->accept(print);
+    if (bench_lexer)
+        return benchmark_lexers(files);
+
+    if (bench_parser)
+        return benchmark_parsers(files, opts.lexer);
+
+    // the server does the compiling, with its own options
+    if (!client_socket.empty())
+        return compile_remote(client_socket, files, "output.s") ? 0 : 1;
 
-    std::ofstream out("output.s");
-    AstNodeCodeGenerator codegen(semant.get_inherit_graph(), out);
-    ast_root->accept(codegen);
+    ThreadPool pool(num_jobs);
+
+    if (!server_socket.empty())
+        return CompileServer(server_socket, opts, pool).run() ? 0 : 1;
+
+    // the ASTs of a batch would be of no use interleaved on std::cout
+    if (!manifest.empty())
+    {
+        opts.print_ast = false;
+        return compile_batch(manifest, opts, pool) ? 0 : 1;
+    }
 
-    return 0;
+    CompilerContext ctx(std::cerr);
+    return compile(ctx, files, "output.s", opts, &pool) ? 0 : 1;
 }
@@ -0,0 +1,174 @@
+#include "parsecontext.hpp"
+#include "cool.tab.hh"
+#include "handparser.hpp"
+
+#include <sstream>
+
+namespace
+{
+    // utility function for converting bison tokens to its string representation
+    // for better error reporting
+    std::string convert_token(int token, const ParserType& val)
+    {
+        std::string rep;
+
+        switch (token)
+        {
+            case CLASS: rep = "class"; break;
+            case ELSE: rep = "else"; break;
+            case FI: rep = "fi"; break;
+            case IF: rep = "if"; break;
+            case IN: rep = "in"; break;
+            case INHERITS: rep = "inherits"; break;
+            case LET: rep = "let"; break;
+            case LOOP: rep = "loop"; break;
+            case POOL: rep = "pool"; break;
+            case THEN: rep = "then"; break;
+            case WHILE: rep = "while"; break;
+            case CASE: rep = "case"; break;
+            case ESAC: rep = "esac"; break;
+            case OF: rep = "of"; break;
+            case DARROW: rep = "=>"; break;
+            case NEW: rep = "new"; break;
+            case ISVOID: rep = "isvoid"; break;
+            case ASSIGN: rep = "<-"; break;
+            case NOT: rep = "not"; break;
+            case LE: rep = "<="; break;
+            case STR_CONST: rep = "STR_CONST = " + val.symbol.get_val(); break;
+            case INT_CONST: rep = "INT_CONST = " + val.symbol.get_val(); break;
+            case BOOL_CONST: rep = "BOOL_CONST = " + val.boolean; break;
+            case TYPEID: rep = "TYPEID = " + val.symbol.get_val(); break;
+            case OBJECTID: rep = "OBJECTID = " + val.symbol.get_val(); break;
+            default: rep = (char) token;
+        }
+
+        return rep;
+    }
+}
+
+ParseContext::ParseContext(CompilerContext& compiler, AstArena& ast_arena, LexerKind lexer_kind,
+        ParserKind parser_kind)
+    : sources(compiler.sources), parser(parser_kind), lazy_methods(false), arena(ast_arena),
+      file(SourceLocation::NO_FILE), program(nullptr), lexer(lexer_kind), num_comment(0),
+      error_count(0), last_token(0), scanner(flex_create(*this)), hand_lexer(tokens)
+{
+
+}
+
+ParseContext::~ParseContext()
+{
+    flex_destroy(scanner);
+}
+
+ProgramPtr ParseContext::parse(SourceBuffer& src, SourceLocation::FileId src_file, int first_line)
+{
+    scan(src, src_file, first_line);
+    program = nullptr;
+
+    if (parser == HAND_PARSER)
+        HandParser(*this).parse();
+    else
+        yyparse(*this);
+
+    return program;
+}
+
+ExpressionPtr ParseContext::parse_body(const MethodSource& source, SourceLocation::FileId src_file)
+{
+    SourceBuffer src;
+    src.load_text(source.text.data(), source.text.size());
+    scan(src, src_file, source.first_line);
+
+    ExpressionPtr body = HandParser(*this).parse_body();
+
+    if (error_count > 0)
+        return nullptr;
+
+    return body;
+}
+
+const MethodSource* ParseContext::skip_body()
+{
+    // only the hand lexer can skip source without lexing it
+    if (lexer != HAND_LEXER)
+        return nullptr;
+
+    int first_line = line();
+    boost::string_view text = hand_lexer.skip_block();
+
+    if (text.empty())
+        return nullptr;
+
+    return arena.make<MethodSource>(MethodSource { std::string(text.data(), text.size()), first_line });
+}
+
+void ParseContext::scan(SourceBuffer& src, SourceLocation::FileId src_file, int first_line)
+{
+    file = src_file;
+    error_count = 0;
+    diagnostics.clear();
+    lex_error_msg.clear();
+    tokens.clear();
+    constants.clear();
+
+    if (lexer == HAND_LEXER)
+        hand_lexer.scan(src, first_line);
+    else
+        flex_scan(scanner, src, first_line);
+}
+
+int ParseContext::lex(ParserType& val)
+{
+    if (lexer == HAND_LEXER)
+        return hand_lexer.lex(val, lex_error_msg);
+    else
+        return flex_lex(&val, scanner);
+}
+
+int ParseContext::line() const
+{
+    if (lexer == HAND_LEXER)
+        return hand_lexer.get_line();
+    else
+        return flex_lineno(scanner);
+}
+
+IntConst* ParseContext::add_int(const Symbol& token)
+{
+    IntConst* node = arena.make<IntConst>(token);
+    constants.ints.push_back(node);
+    return node;
+}
+
+StringConst* ParseContext::add_string(const Symbol& token)
+{
+    StringConst* node = arena.make<StringConst>(token);
+    constants.strings.push_back(node);
+    return node;
+}
+
+void ParseContext::syntax_error()
+{
+    const std::string& filename = sources.get_filename(file);
+    std::ostringstream err;
+
+    if (lex_error_msg.length() <= 0)
+        err << filename << ":" << line() << ": " << "error: " <<  "syntax error near or at character or token '" << convert_token(last_token, last_val) << "'\n";
+    else
+        err << filename << ":" << line() << ": " << "error: " << lex_error_msg << "\n";
+
+    diagnostics += err.str();
+    lex_error_msg.clear();
+    ++error_count;
+}
+
+// called by the Bison parser for every token
+int yylex(YYSTYPE* val, YYLTYPE* loc, ParseContext& ctx)
+{
+    int token = ctx.lex(*val);
+
+    loc->first_line = loc->last_line = ctx.line();
+    ctx.last_token = token;
+    ctx.last_val = *val;
+    return token;
+}
@@ -0,0 +1,120 @@
+// State of one parse. The flex scanner and the Bison parser are both
+// reentrant and keep everything they need in a ParseContext, so any number
+// of files can be parsed at the same time, each with its own context. Only
+// the symbol pool and the source files of the compilation (see
+// compilercontext.hpp) are shared.
+
+#ifndef PARSECONTEXT_H
+#define PARSECONTEXT_H
+
+#include "flexbison.hpp"
+#include "handlexer.hpp"
+#include "astarena.hpp"
+#include "compilercontext.hpp"
+#include "constantpool.hpp"
+#include "sourcebuffer.hpp"
+#include "sourcemanager.hpp"
+#include "tokentable.hpp"
+
+#include <cstddef>
+#include <string>
+
+// Scanners the parser can take its tokens from: the flex scanner generated
+// from cool.l and the hand written one in handlexer.hpp. They produce the
+// same tokens
+enum LexerKind
+{
+    FLEX_LEXER,
+    HAND_LEXER
+};
+
+// Parsers that can build the AST: the Bison parser generated from cool.yc
+// and the hand written one in handparser.hpp. They build the same AST and
+// report the same errors
+enum ParserKind
+{
+    BISON_PARSER,
+    HAND_PARSER
+};
+
+class ParseContext
+{
+public:
+    const SourceManager& sources; // files of the compilation, to name them in errors
+
+    // used by the parser actions
+    ParserKind parser;
+    bool lazy_methods; // the hand parser skips method bodies, see lazymethods.hpp
+    AstArena& arena; // where the nodes are allocated, must outlive the program
+    SourceLocation::FileId file; // file being parsed
+    ProgramPtr program; // set when the whole file has been parsed
+    LocalConstants constants; // constant nodes built, for the caller to add to the pool
+
+    // used by the lexers
+    LexerKind lexer;
+    LocalTokens tokens; // identifiers and constants seen since the scan started
+    std::string lex_error_msg; // message of the last ERROR token, cleared once reported
+    std::string string_buf; // buffer to build string constants in, grows as needed
+    int num_comment; // number of comments open in the flex scanner
+
+    // used by the error routine. Messages are collected rather than printed
+    // so that parses running at the same time don't mix their output
+    std::string diagnostics;
+    std::size_t error_count;
+    int last_token; // lookahead token when an error is reported
+    ParserType last_val;
+
+private:
+    void* scanner; // flex scanner
+    HandLexer hand_lexer;
+
+public:
+    // The nodes are allocated in the given arena, which needn't be the
+    // compilation's, and the identifiers are merged into the compilation's
+    ParseContext(CompilerContext&, AstArena&, LexerKind = FLEX_LEXER, ParserKind = BISON_PARSER);
+    ~ParseContext();
+
+    ParseContext(const ParseContext&) = delete;
+    ParseContext& operator=(const ParseContext&) = delete;
+
+    // Parses the source registered as file, returns the program built or
+    // nullptr if nothing could be parsed. The program is only usable if
+    // error_count is 0 afterwards. Its constants are left in constants, to be added to the
+    // pool in source order. first_line is the number of the first line of the
+    // source, which is not 1 when the source is a piece of a larger file
+    ProgramPtr parse(SourceBuffer&, SourceLocation::FileId, int first_line = 1);
+
+    // Parses the source of a method body skipped with lazy_methods, with
+    // the hand parser. Returns the body, or nullptr if it has errors
+    ExpressionPtr parse_body(const MethodSource&, SourceLocation::FileId);
+
+    // Used by the hand parser with lazy_methods: skips the body of a method
+    // whose '{' is the last token read and returns its source, or nullptr if
+    // the body can't be skipped and has to be parsed now
+    const MethodSource* skip_body();
+
+    // Token level interface, used by the parser and by the lexer benchmark.
+    // scan starts reading the source from its first line, lex returns the
+    // next token and its value, 0 at the end of the source
+    void scan(SourceBuffer&, SourceLocation::FileId, int first_line = 1);
+    int lex(ParserType&);
+
+    // line of the last token read
+    int line() const;
+
+    // location of a line of the file being parsed
+    SourceLocation location(int line) const
+    {
+        return sources.location(file, line);
+    }
+
+    // build constant nodes and collect them in constants
+    IntConst* add_int(const Symbol&);
+    StringConst* add_string(const Symbol&);
+
+    // Reports a syntax error at the last token read, or the lexical error
+    // if that token was an ERROR
+    void syntax_error();
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "parsedriver.hpp"
+#include "classsplitter.hpp"
+#include "sourcebuffer.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace
+{
+    // files at least this big are cut into chunks
+    const std::size_t SPLIT_SIZE = 1024 * 1024;
+
+    // chunks smaller than this aren't worth a task of their own
+    const std::size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+    // a file is cut into more chunks than there are workers, so that workers
+    // done early can help with the rest
+    const std::size_t CHUNKS_PER_WORKER = 4;
+
+    // Part of a file parsed by one task, the whole file unless it was cut
+    class ChunkJob
+    {
+    public:
+        std::size_t begin;
+        std::size_t end;
+        int first_line;
+        AstArena arena; // handed over to the main arena once the parse is done
+        ProgramPtr program;
+        LocalConstants constants; // added to the pool once all chunks are done
+        std::size_t error_count;
+        std::string diagnostics;
+
+        ChunkJob(std::size_t b, std::size_t e, int line)
+            : begin(b), end(e), first_line(line), program(nullptr), error_count(0)
+        {
+
+        }
+    };
+
+    class FileJob
+    {
+    public:
+        std::string filename;
+        SourceLocation::FileId file;
+        SourceBuffer src;
+        bool opened;
+        std::vector<std::unique_ptr<ChunkJob>> chunks; // in source order
+
+        // the file is loaded here, since registering it takes its size
+        FileJob(const std::string& name, SourceManager& sources)
+            : filename(name), file(SourceLocation::NO_FILE), opened(src.load_file(name))
+        {
+            if (opened)
+                file = sources.add_file(name, src.size());
+        }
+    };
+
+    void parse_chunk(CompilerContext& compiler, ChunkJob& chunk, SourceBuffer& src,
+            SourceLocation::FileId file, LexerKind lexer, ParserKind parser, bool lazy)
+    {
+        ParseContext ctx(compiler, chunk.arena, lexer, parser);
+        ctx.lazy_methods = lazy;
+        chunk.program = ctx.parse(src, file, chunk.first_line);
+        chunk.constants = std::move(ctx.constants);
+        chunk.error_count = ctx.error_count;
+        chunk.diagnostics = std::move(ctx.diagnostics);
+    }
+
+    // Cuts the file at class boundaries into chunks of about the same size
+    void split_file(FileJob& job, std::size_t workers)
+    {
+        std::vector<ClassStart> starts = find_class_starts(job.src.data(), job.src.size());
+        std::size_t target = std::max(MIN_CHUNK_SIZE, job.src.size() / (workers * CHUNKS_PER_WORKER));
+
+        // the first chunk also takes whatever comes before the first class
+        std::size_t begin = 0;
+        int line = 1;
+
+        for (auto& start : starts)
+        {
+            if (start.offset - begin >= target)
+            {
+                job.chunks.emplace_back(new ChunkJob(begin, start.offset, line));
+                begin = start.offset;
+                line = start.line;
+            }
+        }
+
+        job.chunks.emplace_back(new ChunkJob(begin, job.src.size(), line));
+    }
+
+    void parse_file(CompilerContext& compiler, FileJob& job, LexerKind lexer, ParserKind parser, bool lazy,
+            ThreadPool& pool)
+    {
+        if (!job.opened || job.file == SourceLocation::NO_FILE)
+            return;
+
+        if (pool.size() > 1 && job.src.size() >= SPLIT_SIZE)
+            split_file(job, pool.size());
+
+        if (job.chunks.size() <= 1)
+        {
+            job.chunks.clear();
+            job.chunks.emplace_back(new ChunkJob(0, job.src.size(), 1));
+            parse_chunk(compiler, *job.chunks.front(), job.src, job.file, lexer, parser, lazy);
+            return;
+        }
+
+        // the lexers write into the buffer they scan, so every chunk is
+        // parsed from a copy and the file stays intact in case it has to be
+        // parsed again as a whole
+        for (auto& chunk : job.chunks)
+        {
+            CompilerContext* comp = &compiler;
+            FileJob* j = &job;
+            ChunkJob* c = chunk.get();
+            pool.submit([comp, j, c, lexer, parser, lazy]()
+            {
+                SourceBuffer src;
+                src.load_text(j->src.data() + c->begin, c->end - c->begin);
+                parse_chunk(*comp, *c, src, j->file, lexer, parser, lazy);
+            });
+        }
+    }
+}
+
+std::size_t parse_files(CompilerContext& compiler, const std::vector<std::string>& files, LexerKind lexer,
+        ParserKind parser, bool lazy_methods, ThreadPool& pool, Classes& classes)
+{
+    // every file is loaded and registered before the workers start, see
+    // SourceManager
+    std::vector<std::unique_ptr<FileJob>> jobs;
+    for (auto& filename : files)
+        jobs.emplace_back(new FileJob(filename, compiler.sources));
+
+    for (auto& job : jobs)
+    {
+        CompilerContext* comp = &compiler;
+        FileJob* j = job.get();
+        ThreadPool* p = &pool;
+        pool.submit([comp, j, lexer, parser, lazy_methods, p]()
+        {
+            parse_file(*comp, *j, lexer, parser, lazy_methods, *p);
+        });
+    }
+    pool.wait();
+
+    std::size_t errors = 0;
+    for (auto& job : jobs)
+    {
+        if (!job->opened)
+        {
+            utility::print_error(compiler.errors, job->filename, "cannot be opened");
+            continue;
+        }
+
+        if (job->file == SourceLocation::NO_FILE)
+        {
+            utility::print_error(compiler.errors, job->filename, "too many source lines");
+            ++errors;
+            continue;
+        }
+
+        bool failed = std::any_of(begin(job->chunks), end(job->chunks),
+                [](const std::unique_ptr<ChunkJob>& chunk) { return chunk->error_count > 0; });
+
+        // the file was cut in the wrong place or it has errors, either way
+        // only a parse of the whole file reports them right
+        if (failed && job->chunks.size() > 1)
+        {
+            job->chunks.clear();
+            job->chunks.emplace_back(new ChunkJob(0, job->src.size(), 1));
+            parse_chunk(compiler, *job->chunks.front(), job->src, job->file, lexer, parser, lazy_methods);
+        }
+
+        for (auto& chunk : job->chunks)
+        {
+            compiler.errors << chunk->diagnostics;
+            errors += chunk->error_count;
+
+            if (chunk->program)
+                classes.insert(classes.end(), chunk->program->classes.begin(), chunk->program->classes.end());
+
+            // in source order, so the constants are numbered the same way
+            // whatever order the chunks were parsed in
+            if (chunk->error_count == 0)
+                compiler.constants.add_all(chunk->constants);
+
+            compiler.arena.splice(chunk->arena);
+        }
+    }
+
+    return errors;
+}
@@ -0,0 +1,28 @@
+// Parses the input files of a compilation on a thread pool.
+// Every file is parsed by a task of its own. Files big enough to be worth it
+// are also cut into chunks of classes (see classsplitter.hpp) which are
+// parsed at the same time, with their real line numbers; if any chunk of a
+// file fails to parse, the file is parsed again as a whole so that errors
+// are reported as they would be without the split.
+
+#ifndef PARSEDRIVER_H
+#define PARSEDRIVER_H
+
+#include "ast.hpp"
+#include "compilercontext.hpp"
+#include "parsecontext.hpp"
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Parses the files of a compilation and adds their classes to classes, in
+// the order the files were given whichever parse finishes first. Errors are
+// printed to the compilation's errors in the same order, the nodes end up in
+// its arena. Returns the number of lexical and syntax errors found. With
+// lazy_methods, method bodies are skipped, see lazymethods.hpp
+std::size_t parse_files(CompilerContext&, const std::vector<std::string>& files, LexerKind, ParserKind,
+        bool lazy_methods, ThreadPool&, Classes&);
+
+#endif
@@ -0,0 +1,118 @@
+#include "parserbench.hpp"
+#include "astnodevisitor.hpp"
+#include "sourcebuffer.hpp"
+#include "utility.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    // What a parse produced, in a form that can be compared
+    class ParseResult
+    {
+    public:
+        std::string ast; // dump of the AST with node lines
+        std::string diagnostics;
+        std::size_t ast_bytes;
+    };
+
+    ParseResult parse(CompilerContext& compiler, SourceBuffer& src, SourceLocation::FileId file,
+            LexerKind lexer, ParserKind parser)
+    {
+        AstArena arena;
+        ParseContext ctx(compiler, arena, lexer, parser);
+        ProgramPtr program = ctx.parse(src, file);
+
+        // the AST of a source with errors is thrown away, and the Bison
+        // parser leaves null classes in it where it recovered
+        std::ostringstream ast;
+        if (program && ctx.error_count == 0)
+        {
+            AstNodeDisplayer display(ast, AstNodeDisplayer::DISPLAYALL, &compiler.sources);
+            program->accept(display);
+        }
+
+        return ParseResult { ast.str(), ctx.diagnostics, arena.size() };
+    }
+
+    // parses the source until about a second has passed, returns bytes per second
+    double measure(CompilerContext& compiler, SourceBuffer& src, SourceLocation::FileId file,
+            LexerKind lexer, ParserKind parser)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        Clock::time_point start = Clock::now();
+        std::size_t runs = 0;
+        double secs;
+
+        do
+        {
+            AstArena arena;
+            ParseContext ctx(compiler, arena, lexer, parser);
+            ctx.parse(src, file);
+
+            ++runs;
+            secs = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (secs < 1.0);
+
+        return runs * src.size() / secs;
+    }
+}
+
+int benchmark_parsers(const std::vector<std::string>& files, LexerKind lexer)
+{
+    int status = 0;
+    CompilerContext compiler(std::cerr);
+
+    for (auto& file : files)
+    {
+        SourceBuffer src;
+
+        if (!src.load_file(file))
+        {
+            utility::print_error(file, "cannot be opened");
+            status = 1;
+            continue;
+        }
+
+        SourceLocation::FileId file_id = compiler.sources.add_file(file, src.size());
+        if (file_id == SourceLocation::NO_FILE)
+        {
+            utility::print_error(file, "too many source lines");
+            status = 1;
+            continue;
+        }
+
+        ParseResult bison = parse(compiler, src, file_id, lexer, BISON_PARSER);
+        double bison_rate = measure(compiler, src, file_id, lexer, BISON_PARSER);
+
+        ParseResult hand = parse(compiler, src, file_id, lexer, HAND_PARSER);
+        double hand_rate = measure(compiler, src, file_id, lexer, HAND_PARSER);
+
+        std::cout << file << ": " << src.size() << " bytes\n"
+                  << std::fixed << std::setprecision(1)
+                  << "    bison: " << bison_rate / 1e6 << " MB/s, "
+                  << bison.ast_bytes / 1024 << " KB of nodes\n"
+                  << "    hand:  " << hand_rate / 1e6 << " MB/s, "
+                  << hand.ast_bytes / 1024 << " KB of nodes ("
+                  << std::setprecision(2) << hand_rate / bison_rate << "x)\n";
+
+        if (bison.ast != hand.ast)
+        {
+            utility::print_error(file, "parsers build different ASTs");
+            status = 1;
+        }
+
+        if (bison.diagnostics != hand.diagnostics)
+        {
+            utility::print_error(file, "parsers report different errors");
+            std::cerr << "bison:\n" << bison.diagnostics << "hand:\n" << hand.diagnostics;
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,19 @@
+// Benchmark of the parsers, run as coolc --bench-parser FILE...
+// Every file is parsed repeatedly by each parser for about a second and the
+// rate is reported along with the memory taken by the AST. The parsers are
+// also checked against each other: the ASTs, including the line of every
+// node, and the errors reported must be the same, so the benchmark fails if
+// the parsers disagree on any file.
+
+#ifndef PARSERBENCH_H
+#define PARSERBENCH_H
+
+#include "parsecontext.hpp"
+
+#include <string>
+#include <vector>
+
+// returns the exit status, 0 if all files were read and the parsers agree
+int benchmark_parsers(const std::vector<std::string>&, LexerKind);
+
+#endif
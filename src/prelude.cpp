@@ -0,0 +1,49 @@
+#include "prelude.hpp"
+#include "astarena.hpp"
+
+namespace
+{
+    // Makes the nodes of the basic classes. They never change afterwards,
+    // the later stages only read them
+    class Prelude
+    {
+    private:
+        AstArena arena;
+
+    public:
+        Classes classes;
+
+        Prelude()
+        {
+            using namespace prelude;
+
+            for (auto& spec : CLASSES)
+            {
+                Methods methods;
+                for (std::size_t i = spec.first_method; i < spec.first_method + spec.num_methods; ++i)
+                {
+                    const MethodSpec& method = METHODS[i];
+                    Formals formals;
+
+                    for (std::size_t p = 0; p < method.num_params; ++p)
+                        formals.push_back(arena.make<Formal>(method.params[p].name, method.params[p].type));
+
+                    methods.push_back(arena.make<Method>(method.name, method.return_type, std::move(formals),
+                                arena.make<NoExpr>()));
+                }
+
+                Attributes attributes;
+                for (std::size_t i = spec.first_attr; i < spec.first_attr + spec.num_attrs; ++i)
+                    attributes.push_back(arena.make<Attribute>(ATTRS[i].name, ATTRS[i].type, arena.make<NoExpr>()));
+
+                classes.push_back(arena.make<Class>(spec.name, spec.parent, std::move(attributes), std::move(methods)));
+            }
+        }
+    };
+}
+
+const Classes& prelude::classes()
+{
+    static const Prelude prelude;
+    return prelude.classes;
+}
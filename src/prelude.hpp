@@ -0,0 +1,128 @@
+// The basic classes Object, IO, Int, Bool and String. They are described by
+// constant tables that the compiler evaluates when coolc is built, along with
+// the size of their dispatch tables and objects, so nothing about them is
+// worked out again when a program is compiled. Their AST nodes and layout
+// are made from the tables once per process and are shared, unchanged, by
+// every compilation: the class table of a compilation starts out with the
+// basic classes and the user's classes are added after them.
+
+#ifndef PRELUDE_H
+#define PRELUDE_H
+
+#include "ast.hpp"
+#include "constants.hpp"
+
+#include <cstddef>
+
+namespace prelude
+{
+    class FormalSpec
+    {
+    public:
+        Symbol name;
+        Symbol type;
+    };
+
+    class MethodSpec
+    {
+    public:
+        Symbol name;
+        Symbol return_type;
+        std::size_t num_params;
+        FormalSpec params[2];
+    };
+
+    class AttrSpec
+    {
+    public:
+        Symbol name;
+        Symbol type;
+    };
+
+    class ClassSpec
+    {
+    public:
+        Symbol name;
+        Symbol parent;
+        int parent_id; // -1 for Object
+        std::size_t first_method; // in METHODS
+        std::size_t num_methods;
+        std::size_t first_attr; // in ATTRS
+        std::size_t num_attrs;
+    };
+
+    // The basic classes take the first class ids, in this order, which
+    // puts every class after its parent
+    enum ClassId
+    {
+        OBJECT_CLASS,
+        IO_CLASS,
+        INT_CLASS,
+        BOOL_CLASS,
+        STRING_CLASS,
+        CLASS_COUNT
+    };
+
+    constexpr MethodSpec METHODS[] = {
+        { constants::ABORT, constants::OBJECT, 0, {} },
+        { constants::TYPE_NAME, constants::STRING, 0, {} },
+        { constants::COPY, constants::SELF_TYPE, 0, {} },
+        { constants::OUT_STRING, constants::SELF_TYPE, 1, { { constants::ARG, constants::STRING } } },
+        { constants::OUT_INT, constants::SELF_TYPE, 1, { { constants::ARG, constants::INTEGER } } },
+        { constants::IN_STRING, constants::STRING, 0, {} },
+        { constants::IN_INT, constants::INTEGER, 0, {} },
+        { constants::LENGTH, constants::INTEGER, 0, {} },
+        { constants::CONCAT, constants::STRING, 1, { { constants::ARG, constants::STRING } } },
+        { constants::SUBSTR, constants::STRING, 2,
+            { { constants::ARG, constants::INTEGER }, { constants::ARG2, constants::INTEGER } } }
+    };
+
+    // the values of Int, Bool and String objects are in slots the code
+    // generator doesn't initialize
+    constexpr AttrSpec ATTRS[] = {
+        { constants::VAL, constants::PRIM_SLOT }, // Int
+        { constants::VAL, constants::PRIM_SLOT }, // Bool
+        { constants::VAL, constants::PRIM_SLOT }, // String
+        { constants::STR_FIELD, constants::PRIM_SLOT }
+    };
+
+    constexpr ClassSpec CLASSES[CLASS_COUNT] = {
+        { constants::OBJECT, constants::NOCLASS, -1, 0, 3, 0, 0 },
+        { constants::IO, constants::OBJECT, OBJECT_CLASS, 3, 4, 0, 0 },
+        { constants::INTEGER, constants::OBJECT, OBJECT_CLASS, 0, 0, 0, 1 },
+        { constants::BOOLEAN, constants::OBJECT, OBJECT_CLASS, 0, 0, 1, 1 },
+        { constants::STRING, constants::OBJECT, OBJECT_CLASS, 7, 3, 2, 2 }
+    };
+
+    // Number of entries in the dispatch table of a basic class. None of
+    // them overrides a method, so it is the number of methods of the class
+    // and its ancestors
+    constexpr std::size_t method_count(int id)
+    {
+        return id < 0 ? 0 : CLASSES[id].num_methods + method_count(CLASSES[id].parent_id);
+    }
+
+    // number of attributes of a basic class, including the inherited ones
+    constexpr std::size_t attr_count(int id)
+    {
+        return id < 0 ? 0 : CLASSES[id].num_attrs + attr_count(CLASSES[id].parent_id);
+    }
+
+    constexpr bool parents_first(int id)
+    {
+        return id == CLASS_COUNT ||
+            (CLASSES[id].parent_id < id && parents_first(id + 1));
+    }
+
+    static_assert(parents_first(0), "a basic class comes before its parent");
+    static_assert(method_count(IO_CLASS) == 7 && method_count(STRING_CLASS) == 6,
+            "wrong number of methods in the basic classes");
+    static_assert(attr_count(INT_CLASS) == 1 && attr_count(STRING_CLASS) == 2,
+            "wrong number of attributes in the basic classes");
+
+    // nodes of the basic classes by class id, made from the tables the
+    // first time they're needed
+    const Classes& classes();
+}
+
+#endif
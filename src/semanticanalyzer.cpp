@@ -3,62 +3,49 @@
 #include "astnodetypechecker.hpp"
 #include "utility.hpp"
 
-#include <iostream>
 #include <algorithm>
+#include <string>
 
 using namespace constants;
 
-void SemanticAnalyzer::install_basic(ProgramPtr& ast_root)
+namespace
 {
-    Methods object_methods = { 
-        std::make_shared<Method>(ABORT, OBJECT, Formals(), std::make_shared<NoExpr>()),
-        std::make_shared<Method>(TYPE_NAME, STRING, Formals(), std::make_shared<NoExpr>()),
-        std::make_shared<Method>(COPY, SELF_TYPE, Formals(), std::make_shared<NoExpr>())
-    };
-
-    ast_root->classes.push_back(std::make_shared<Class>(OBJECT, NOCLASS, Attributes(), object_methods));
-
-    Formals io_formal1 = { std::make_shared<Formal>(ARG, STRING) };
-    Formals io_formal2 = { std::make_shared<Formal>(ARG, INTEGER) };
-    Methods io_methods = {
-        std::make_shared<Method>(OUT_STRING, SELF_TYPE, io_formal1, std::make_shared<NoExpr>()),
-        std::make_shared<Method>(OUT_INT, SELF_TYPE, io_formal2, std::make_shared<NoExpr>()),
-        std::make_shared<Method>(IN_STRING, STRING, Formals(), std::make_shared<NoExpr>()),
-        std::make_shared<Method>(IN_INT, INTEGER, Formals(), std::make_shared<NoExpr>())
-    };
-
-    ast_root->classes.push_back(std::make_shared<Class>(IO, OBJECT, Attributes(), io_methods));
-
-    Attributes int_attributes = {
-        std::make_shared<Attribute>(VAL, PRIM_SLOT, std::make_shared<NoExpr>())
-    };
+    // the classes are cut into more batches than there are workers, so that
+    // workers done early can help with the rest
+    const std::size_t BATCHES_PER_WORKER = 4;
 
-    ast_root->classes.push_back(std::make_shared<Class>(INTEGER, OBJECT, int_attributes, Methods()));
+    // batches with fewer classes than this aren't worth a task of their own
+    const std::size_t MIN_BATCH_SIZE = 16;
 
-    Attributes bool_attributes = {
-        std::make_shared<Attribute>(VAL, PRIM_SLOT, std::make_shared<NoExpr>())
-    };
-
-    ast_root->classes.push_back(std::make_shared<Class>(BOOLEAN, OBJECT, bool_attributes, Methods()));
+    // Classes checked by one task, with a checker of its own. The errors of
+    // the override checks are kept apart from the others since a serial
+    // check reports those of every class first
+    class CheckBatch
+    {
+    public:
+        std::size_t begin;
+        std::size_t end;
+        std::string override_errors;
+        std::string body_errors;
+        std::size_t error_count;
+
+        CheckBatch(std::size_t b, std::size_t e)
+            : begin(b), end(e), error_count(0)
+        {
 
-    Formals string_formal1 = { std::make_shared<Formal>(ARG, STRING) };
-    Formals string_formal2 = { 
-        std::make_shared<Formal>(ARG, INTEGER),
-        std::make_shared<Formal>(ARG2, INTEGER)
+        }
     };
+}
 
-    Methods string_methods = {
-        std::make_shared<Method>(LENGTH, INTEGER, Formals(), std::make_shared<NoExpr>()),
-        std::make_shared<Method>(CONCAT, STRING, string_formal1, std::make_shared<NoExpr>()),
-        std::make_shared<Method>(SUBSTR, STRING, string_formal2, std::make_shared<NoExpr>())
-    };
+SemanticAnalyzer::SemanticAnalyzer(CompilerContext& context)
+    : ctx(context)
+{
 
-    Attributes string_attributes = {
-        std::make_shared<Attribute>(VAL, PRIM_SLOT, std::make_shared<NoExpr>()),
-        std::make_shared<Attribute>(STR_FIELD, PRIM_SLOT, std::make_shared<NoExpr>()),    
-    };
+}
 
-    ast_root->classes.push_back(std::make_shared<Class>(STRING, OBJECT, string_attributes, string_methods));
+void SemanticAnalyzer::error(const AstNode& node, const std::string& msg)
+{
+    utility::print_error(ctx.errors, ctx.sources, node, msg);
 }
 
 bool SemanticAnalyzer::invalid_parent(const Symbol& parent)
@@ -66,23 +53,33 @@ bool SemanticAnalyzer::invalid_parent(const Symbol& parent)
     return parent == STRING || parent == BOOLEAN || parent == INTEGER;
 }
 
-bool SemanticAnalyzer::cyclic_check(ClassPtrMap& graph, const ClassPtr& node)
+bool SemanticAnalyzer::cyclic_check(ClassTable::ClassId id)
 {
-    if (node->name == OBJECT || node->name == IO || node->name == NOCLASS)
-        return true;
+    std::vector<ClassTable::ClassId> path;
 
-    if (visited.count(node) == 1 && processed.count(node) == 0)
+    // walk up the inheritance tree until a class that's already known
+    // to be free of cycles (or the top of the tree) is reached
+    while (id != ClassTable::NO_CLASS_ID && !processed[id])
     {
-        utility::print_error(node, "cyclic dependency found in class " + node->name.get_val());
-        return false;
-    }
+        const ClassPtr& node = class_table.get_class(id);
+
+        if (node->name == OBJECT || node->name == IO)
+            break;
+
+        if (visited[id])
+        {
+            error(*node, "cyclic dependency found in class " + node->name.get_val());
+            return false;
+        }
 
-    visited.insert(node);
+        visited[id] = true;
+        path.push_back(id);
+        id = class_table.get_parent(id);
+    }
 
-    if(!cyclic_check(graph, graph[node]))
-        return false;
+    for (auto p : path)
+        processed[p] = true;
 
-    processed.insert(node);
     return true;
 }
 
@@ -95,73 +92,125 @@ bool SemanticAnalyzer::validate_inheritance(const Classes& classes)
 
         if (invalid_parent(c->parent))
         {
-            utility::print_error(c, "cannot inherit from basic class " + c->parent.get_val());
+            error(*c, "cannot inherit from basic class " + c->parent.get_val());
             status = false;
         }
 
-        if (inherit_graph.count(c) > 0)
+        if (class_table.add(c) == ClassTable::NO_CLASS_ID)
         {
             if (utility::is_basic_class(c->name))
-                utility::print_error(c, "redefinition of basic class " + c->name.get_val() + " not allowed");
+                error(*c, "redefinition of basic class " + c->name.get_val() + " not allowed");
             else
-                utility::print_error(c, "class " + c->name.get_val() + " has multiple definitions");
+                error(*c, "class " + c->name.get_val() + " has multiple definitions");
 
             status = false;
         }
+    }
+
+    for (std::size_t id = 0; id < class_table.size(); ++id)
+    {
+        const ClassPtr& c = class_table.get_class(id);
+
+        // Object is the top of the class hierarchy, its parent is NoClass
+        if (c->name == OBJECT)
+            continue;
 
-        auto parent = std::find_if(begin(classes), end(classes), 
-                [&](const ClassPtr& p) { 
-                    return c->parent == p->name;
-                });
+        auto parent = class_table.find(c->parent);
 
-        if (parent == end(classes))
+        if (parent == ClassTable::NO_CLASS_ID)
         {
-            if (c->name == OBJECT)
-            {
-                // The Object class' parent is not included in the classes list so we explicitly add a parent NoClass
-                // to signal that the end of the class hierarchy is reached.
-                ClassPtr noclass = std::make_shared<Class>(NOCLASS, NOCLASS, Attributes(), Methods());
-                inherit_graph[c] = noclass;
-                inherit_graph[noclass] = noclass;
-            }
-            else
-            {
-                utility::print_error(c, c->name.get_val() + " inherits from a class that doesn't exist");
-                status = false;
-            }
+            error(*c, c->name.get_val() + " inherits from a class that doesn't exist");
+            status = false;
         }
         else
         {
-            inherit_graph[c] = *parent;
+            class_table.set_parent(id, parent);
         }
     }
 
-    auto main_class = std::find_if(begin(classes), end(classes),
-                [&](const ClassPtr& p) {
-                    return p->name == MAIN;
-                }); 
-
-    if (main_class == end(classes))
+    if (class_table.find(MAIN) == ClassTable::NO_CLASS_ID)
     {
-        std::cerr << "error:Main class not found.\n";
+        ctx.errors << "error:Main class not found.\n";
         status = false;
     }
 
-    for (auto& elem : inherit_graph)
-        if (!cyclic_check(inherit_graph, elem.first))
+    visited.assign(class_table.size(), false);
+    processed.assign(class_table.size(), false);
+
+    for (std::size_t id = 0; id < class_table.size(); ++id)
+        if (!cyclic_check(id))
             status = false;
 
+    if (status)
+    {
+        class_table.build_index();
+        class_layout.build(class_table);
+    }
+
     return status;
 }
 
-bool SemanticAnalyzer::type_check(const ProgramPtr& root)
+bool SemanticAnalyzer::type_check(const ProgramPtr& root, ThreadPool* pool)
+{
+    const Classes& classes = root->classes;
+    std::size_t num_batches = pool ? pool->size() * BATCHES_PER_WORKER : 1;
+    std::size_t batch_size = std::max(MIN_BATCH_SIZE, (classes.size() + num_batches - 1) / num_batches);
+
+    if (!pool || pool->size() <= 1 || classes.size() <= batch_size)
+    {
+        AstNodeTypeChecker typechecker(ctx.sources, class_table, class_layout);
+        root->accept(typechecker);
+        ctx.errors << typechecker.diagnostics;
+        return typechecker.get_err_count() == 0;
+    }
+
+    std::vector<CheckBatch> batches;
+    for (std::size_t begin = 0; begin < classes.size(); begin += batch_size)
+        batches.emplace_back(begin, std::min(begin + batch_size, classes.size()));
+
+    // the tables are only read from here on, and each task only writes to
+    // the nodes of its own classes
+    for (auto& batch : batches)
+    {
+        CheckBatch* b = &batch;
+        pool->submit([this, b, &classes]()
+        {
+            AstNodeTypeChecker typechecker(ctx.sources, class_table, class_layout);
+
+            for (std::size_t i = b->begin; i < b->end; ++i)
+                typechecker.check_overrides(*classes[i]);
+
+            b->override_errors.swap(typechecker.diagnostics);
+
+            for (std::size_t i = b->begin; i < b->end; ++i)
+                classes[i]->accept(typechecker);
+
+            b->body_errors.swap(typechecker.diagnostics);
+            b->error_count = typechecker.get_err_count();
+        });
+    }
+
+    pool->wait();
+
+    std::size_t errors = 0;
+    for (auto& batch : batches)
+    {
+        ctx.errors << batch.override_errors;
+        errors += batch.error_count;
+    }
+
+    for (auto& batch : batches)
+        ctx.errors << batch.body_errors;
+
+    return errors == 0;
+}
+
+const ClassTable& SemanticAnalyzer::get_class_table() const
 {
-    AstNodeTypeChecker typechecker(inherit_graph);
-    root->accept(typechecker);
-    return typechecker.get_err_count() == 0;
+    return class_table;
 }
 
-ClassPtrMap SemanticAnalyzer::get_inherit_graph() const
+const ClassLayout& SemanticAnalyzer::get_class_layout() const
 {
-    return inherit_graph;
+    return class_layout;
 }
@@ -2,45 +2,50 @@
 #define SEMANTICANALYZER_H
 
 #include "ast.hpp"
+#include "classtable.hpp"
+#include "classlayout.hpp"
+#include "compilercontext.hpp"
+#include "threadpool.hpp"
 
-#include <map>
-#include <set>
 #include <vector>
-#include <memory>
 #include <functional>
 
-typedef std::map<ClassPtr, ClassPtr> ClassPtrMap;
-
 //Class that contains methods to perform semantic analysis, as well as 
 //data structures that are built along the way 
 class SemanticAnalyzer
 {
 private:
     //The following instance variables are used by the cyclic check function
-    //to keep track of visited & processed inheritance graph nodes
-    std::set<ClassPtr> visited;   
-    std::set<ClassPtr> processed;
+    //to keep track of visited & processed classes, indexed by class id
+    std::vector<bool> visited;   
+    std::vector<bool> processed;
 
-    ClassPtrMap inherit_graph;
+    CompilerContext& ctx; // compilation being analyzed, errors are printed to ctx.errors
+    ClassTable class_table;
+    ClassLayout class_layout; // laid out once the inheritance is known to be valid
 
     bool invalid_parent(const Symbol&); 
 
-    //Performs a DFS traversal of the inheritance graph created from the list
-    //of classes. It checks for cyclic dependencies between classes in the source code.
-    bool cyclic_check(ClassPtrMap&, const ClassPtr&);
+    void error(const AstNode&, const std::string&);
 
-    ClassPtr get_parent(const ClassPtr&, const Classes&);
+    //Follows the parent links of the class table starting from the given class.
+    //It checks for cyclic dependencies between classes in the source code.
+    bool cyclic_check(ClassTable::ClassId);
 
 public:
+    explicit SemanticAnalyzer(CompilerContext&);
+
     //Performs a variety of checks to ensure that the class structure, including
     //inheritance is valid 
     bool validate_inheritance(const Classes&); 
 
-    //Calls on the AST to type check and scope check its nodes
-    bool type_check(const ProgramPtr&);
+    //Calls on the AST to type check and scope check its nodes. With a pool of
+    //more than one worker, batches of classes are checked at the same time
+    //and their errors are printed in source order, as a serial check would
+    bool type_check(const ProgramPtr&, ThreadPool*);
 
-    ClassPtrMap get_inherit_graph() const;
-    void install_basic(ProgramPtr&);
+    const ClassTable& get_class_table() const;
+    const ClassLayout& get_class_layout() const;
 };
 
 #endif
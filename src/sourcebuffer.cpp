@@ -0,0 +1,147 @@
+#include "sourcebuffer.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+const std::size_t SourceBuffer::PADDING;
+
+SourceBuffer::SourceBuffer()
+    : base(nullptr), len(0), mapped_len(0)
+{
+
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other)
+    : base(other.base), len(other.len), mapped_len(other.mapped_len),
+      storage(std::move(other.storage))
+{
+    other.base = nullptr;
+    other.len = 0;
+    other.mapped_len = 0;
+}
+
+SourceBuffer::~SourceBuffer()
+{
+    release();
+}
+
+void SourceBuffer::release()
+{
+    if (mapped_len > 0)
+        ::munmap(base, mapped_len);
+
+    storage.clear();
+    base = nullptr;
+    len = 0;
+    mapped_len = 0;
+}
+
+bool SourceBuffer::load_file(const std::string& filename)
+{
+    release();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (!S_ISREG(st.st_mode))
+    {
+        bool ok = read_fd(fd);
+        ::close(fd);
+        return ok;
+    }
+
+    std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t file_len = static_cast<std::size_t>(st.st_size);
+    std::size_t total = (file_len + PADDING + page - 1) / page * page;
+
+    // reserve zeroed pages for the file and the padding, then map the file
+    // over the front of them. The tail of the file's last page reads as zero
+    // as well, so the padding is there whether or not it shares that page
+    void* mem = ::mmap(nullptr, total, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (file_len > 0 && ::mmap(mem, file_len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        ::munmap(mem, total);
+        bool ok = read_fd(fd);
+        ::close(fd);
+        return ok;
+    }
+
+    ::close(fd);
+
+    base = static_cast<char*>(mem);
+    len = file_len;
+    mapped_len = total;
+    return true;
+}
+
+bool SourceBuffer::load_stdin()
+{
+    release();
+    return read_fd(STDIN_FILENO);
+}
+
+void SourceBuffer::load_text(const char* text, std::size_t size)
+{
+    release();
+
+    storage.reserve(size + PADDING);
+    storage.assign(text, text + size);
+    storage.insert(storage.end(), PADDING, '\0');
+
+    base = storage.data();
+    len = size;
+}
+
+bool SourceBuffer::read_fd(int fd)
+{
+    static const std::size_t CHUNK_SIZE = 64 * 1024;
+
+    std::size_t used = 0;
+
+    for (;;)
+    {
+        storage.resize(used + CHUNK_SIZE);
+
+        ssize_t n = ::read(fd, storage.data() + used, CHUNK_SIZE);
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n < 0)
+        {
+            storage.clear();
+            return false;
+        }
+        else if (n == 0)
+            break;
+
+        used += static_cast<std::size_t>(n);
+    }
+
+    storage.resize(used);
+    storage.insert(storage.end(), PADDING, '\0');
+
+    base = storage.data();
+    len = used;
+    return true;
+}
@@ -0,0 +1,55 @@
+// Contents of a source file, scanned in place by the lexer.
+// Regular files are memory mapped, anything else (stdin, pipes) is read once
+// into memory. Either way the source is followed by PADDING NUL bytes, which
+// is what flex needs to scan a buffer without copying it. The lexer writes
+// into the buffer while scanning, so mappings are private to the process.
+
+#ifndef SOURCEBUFFER_H
+#define SOURCEBUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class SourceBuffer
+{
+private:
+    char* base;
+    std::size_t len; // length of the source, not counting the padding
+    std::size_t mapped_len; // length of the mapping, 0 if the source was read
+    std::vector<char> storage; // holds the source if it was read
+
+    bool read_fd(int);
+    void release();
+
+public:
+    static const std::size_t PADDING = 2;
+
+    SourceBuffer();
+    SourceBuffer(SourceBuffer&&);
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // load the named file, returns false if it cannot be read
+    bool load_file(const std::string&);
+
+    // load everything left on stdin
+    bool load_stdin();
+
+    // load a copy of the text, e.g. a piece of another buffer
+    void load_text(const char*, std::size_t);
+
+    char* data()
+    {
+        return base;
+    }
+
+    std::size_t size() const
+    {
+        return len;
+    }
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "sourcemanager.hpp"
+
+#include <algorithm>
+#include <limits>
+
+const SourceLocation::FileId SourceLocation::NO_FILE;
+
+namespace
+{
+    // a file of n bytes has at most n + 1 lines, numbered from 1
+    std::uint64_t line_slots(std::size_t size)
+    {
+        return static_cast<std::uint64_t>(size) + 2;
+    }
+}
+
+SourceManager::SourceManager()
+    : base(nullptr), first_file(0), first_start(0), filenames(1, "<builtin>"), starts(1, 0),
+      next_start(line_slots(0))
+{
+
+}
+
+SourceManager::SourceManager(const SourceManager* below)
+    : base(below), first_file(static_cast<SourceLocation::FileId>(below->file_count())),
+      first_start(below->next_start), next_start(below->next_start)
+{
+
+}
+
+SourceLocation::FileId SourceManager::add_file(const std::string& filename, std::size_t size)
+{
+    if (next_start + line_slots(size) - 1 > std::numeric_limits<std::uint32_t>::max())
+        return SourceLocation::NO_FILE;
+
+    filenames.push_back(filename);
+    starts.push_back(static_cast<std::uint32_t>(next_start));
+    next_start += line_slots(size);
+
+    return static_cast<SourceLocation::FileId>(file_count() - 1);
+}
+
+SourceLocation::FileId SourceManager::get_file(const SourceLocation& loc) const
+{
+    if (loc.get_index() < first_start)
+        return base->get_file(loc);
+
+    // the last file starting at or before the index
+    auto it = std::upper_bound(starts.begin(), starts.end(), loc.get_index());
+    return static_cast<SourceLocation::FileId>(first_file + (it - starts.begin()) - 1);
+}
+
+std::size_t SourceManager::get_line(const SourceLocation& loc) const
+{
+    if (loc.get_index() < first_start)
+        return base->get_line(loc);
+
+    return loc.get_index() - starts[get_file(loc) - first_file];
+}
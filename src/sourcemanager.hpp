@@ -0,0 +1,113 @@
+// Source files and locations in them.
+// Every file handed to the compiler is registered once with the SourceManager
+// of its compilation and AST nodes only keep a 32-bit SourceLocation that
+// refers back to it, instead of a copy of the filename per node.
+
+#ifndef SOURCEMANAGER_H
+#define SOURCEMANAGER_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A line of the sources of a compilation, as one 32-bit index.
+// Every file registered with the SourceManager gets a range of indexes for
+// its lines, after the range of the file registered before it, and the
+// SourceManager maps an index back to the file and the line. Index 0 is line
+// 0 of file NO_FILE, for nodes that don't come from a source file. Neither
+// lexer tracks columns, so a location only names the line
+class SourceLocation
+{
+private:
+    std::uint32_t index;
+
+public:
+    typedef std::uint32_t FileId;
+    static const FileId NO_FILE = 0;
+
+    SourceLocation()
+        : index(0)
+    {
+
+    }
+
+    explicit SourceLocation(std::uint32_t idx)
+        : index(idx)
+    {
+
+    }
+
+    std::uint32_t get_index() const
+    {
+        return index;
+    }
+};
+
+// Files are all registered by the driver before parsing starts, after
+// that locations can be made and looked up from any thread. A manager can
+// be layered over another one: it knows the files of the one below without
+// copying them, and the files registered with it come after those
+class SourceManager
+{
+private:
+    const SourceManager* base; // manager layered under this one, nullptr if none
+    SourceLocation::FileId first_file; // id of the first file registered with this manager
+    std::uint64_t first_start; // first index not given to a file of base
+    std::vector<std::string> filenames; // [file id - first_file] -> filename
+    std::vector<std::uint32_t> starts; // [file id - first_file] -> index of line 0 of the file, ascending
+    std::uint64_t next_start; // first index not given to a file
+
+    std::uint64_t end_of(SourceLocation::FileId file) const
+    {
+        return file + 1 - first_file < starts.size() ? starts[file + 1 - first_file] : next_start;
+    }
+
+public:
+    SourceManager();
+
+    // A manager over base, which mustn't get files of its own while this
+    // one is in use
+    explicit SourceManager(const SourceManager* base);
+
+    // Registers a file of size bytes and returns its id. The file gets an
+    // index for every line it can have, so its line numbers are exact
+    // whatever its size. Returns NO_FILE once the sources of the
+    // compilation have more lines than fit in a SourceLocation
+    SourceLocation::FileId add_file(const std::string&, std::size_t size);
+
+    SourceLocation location(SourceLocation::FileId file, std::size_t line) const
+    {
+        if (file < first_file)
+            return base->location(file, line);
+
+        std::uint32_t start = starts[file - first_file];
+        assert(start + line < end_of(file));
+
+        return SourceLocation(start + static_cast<std::uint32_t>(line));
+    }
+
+    // the file a location is in, with a binary search of the ranges
+    SourceLocation::FileId get_file(const SourceLocation&) const;
+
+    std::size_t get_line(const SourceLocation& loc) const;
+
+    // files registered, NO_FILE and those of the managers below included
+    std::size_t file_count() const
+    {
+        return first_file + filenames.size();
+    }
+
+    const std::string& get_filename(SourceLocation::FileId file) const
+    {
+        return file < first_file ? base->get_filename(file) : filenames[file - first_file];
+    }
+
+    const std::string& get_filename(const SourceLocation& loc) const
+    {
+        return get_filename(get_file(loc));
+    }
+};
+
+#endif
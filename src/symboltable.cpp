@@ -1,12 +1,96 @@
 #include "symboltable.hpp"
+#include "constants.hpp"
+
+#include <cassert>
+#include <cstring>
 
 Symbol::Symbol(const std::string& val)
-    : value(val) 
+    : id(symbolpool().intern(val))
+{
+
+}
+
+std::size_t SpellingHash::operator()(const boost::string_view& str) const
+{
+    // FNV-1a
+    std::size_t hash = 2166136261u;
+
+    for (char c : str)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+const unsigned SymbolPool::FIRST_SEGMENT_BITS;
+const unsigned SymbolPool::NUM_SEGMENTS;
+
+SymbolPool::SymbolPool()
+    : block_used(BLOCK_SIZE), count(0)
 {
+    // the predefined symbols always receive the same ids so that the
+    // constants can be compared against without consulting the pool
+    for (std::uint32_t i = 0; i < constants::PREDEFINED_COUNT; ++i)
+    {
+        std::uint32_t id = intern(constants::PREDEFINED_SPELLINGS[i]);
+        assert(id == i);
+        (void) id;
+    }
+}
+
+boost::string_view SymbolPool::store(const boost::string_view& str)
+{
+    if (str.empty())
+        return boost::string_view();
+
+    char* dst;
+
+    if (str.size() > BLOCK_SIZE)
+    {
+        // spellings longer than a block get a block of their own. it's put
+        // in front so that blocks.back() stays the block being filled
+        blocks.emplace(begin(blocks), new char[str.size()]);
+        dst = blocks.front().get();
+    }
+    else
+    {
+        if (str.size() > BLOCK_SIZE - block_used)
+        {
+            blocks.emplace_back(new char[BLOCK_SIZE]);
+            block_used = 0;
+        }
+
+        dst = blocks.back().get() + block_used;
+        block_used += str.size();
+    }
 
+    std::memcpy(dst, str.data(), str.size());
+    return boost::string_view(dst, str.size());
 }
 
-std::string Symbol::get_val() const 
+std::uint32_t SymbolPool::intern(const boost::string_view& str)
 {
-    return value;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = ids.find(str);
+    if (it != end(ids))
+        return it->second;
+
+    std::uint32_t id = count.load(std::memory_order_relaxed);
+    unsigned segment;
+    std::size_t offset;
+    locate(id, segment, offset);
+
+    if (!segments[segment])
+        segments[segment].reset(new boost::string_view[std::size_t(1) << (segment + FIRST_SEGMENT_BITS)]);
+
+    boost::string_view stored = store(str);
+    segments[segment][offset] = stored;
+    ids.emplace(stored, id);
+
+    // the view and its segment are written before the id can be seen
+    count.store(id + 1, std::memory_order_release);
+    return id;
 }
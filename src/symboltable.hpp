@@ -1,88 +1,319 @@
 #ifndef SYMBOLTABLE_H
 #define SYMBOLTABLE_H
 
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <boost/optional.hpp>
+#include <boost/utility/string_view.hpp>
 
 // Symbol type used to represent symbols in the language
-// including, but not limited to class and method names, and types
+// including, but not limited to class and method names, and types.
+// A symbol is only a 32-bit id into the global SymbolPool, so copying,
+// comparing and hashing symbols never touches the spelling
 class Symbol 
 {
 private:
-    std::string value;
+    std::uint32_t id;
 
 public:
-    Symbol(const std::string& = "");
+    // the empty symbol, which the pool always interns first
+    constexpr Symbol()
+        : id(0)
+    {
+
+    }
+
+    Symbol(const std::string&);
+
+    // wraps an id previously handed out by the SymbolPool
+    explicit constexpr Symbol(std::uint32_t sym_id)
+        : id(sym_id)
+    {
+
+    }
+
+    constexpr std::uint32_t get_id() const
+    {
+        return id;
+    }
+
+    boost::string_view get_view() const;
     std::string get_val() const;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Symbol& sym)
 {
-    return os << sym.get_val();
+    return os << sym.get_view();
+}
+
+inline constexpr bool operator==(const Symbol& s1, const Symbol& s2)
+{
+    return s1.get_id() == s2.get_id();
+}
+
+inline constexpr bool operator!=(const Symbol& s1, const Symbol& s2)
+{
+    return s1.get_id() != s2.get_id();
+}
+
+// Orders symbols by intern order, not alphabetically. Nothing in the
+// compiler depends on iterating symbol keyed containers alphabetically
+inline constexpr bool operator<(const Symbol& s1, const Symbol& s2)
+{
+    return s1.get_id() < s2.get_id();
 }
 
-inline bool operator==(const Symbol& s1, const Symbol& s2)
+namespace std
+{
+    template<>
+    struct hash<Symbol>
+    {
+        std::size_t operator()(const Symbol& sym) const
+        {
+            return sym.get_id();
+        }
+    };
+}
+
+// Hashes the characters of a spelling
+struct SpellingHash
+{
+    std::size_t operator()(const boost::string_view&) const;
+};
+
+// Global string arena that every Symbol is interned into.
+// Spellings are copied once into large character blocks that are never
+// moved or freed, so the views handed out stay valid for the whole run.
+// The pool is shared by all threads. Interning is serialized by a mutex,
+// looking up a spelling takes no lock: the views are kept in segments
+// that never move either, each twice as big as the one before, and a view
+// is published by the release of the count of symbols
+class SymbolPool
+{
+private:
+    static const std::size_t BLOCK_SIZE = 64 * 1024;
+    static const unsigned FIRST_SEGMENT_BITS = 12; // the first segment has 2^12 views
+    static const unsigned NUM_SEGMENTS = 33 - FIRST_SEGMENT_BITS; // enough for every 32-bit id
+
+    std::vector<std::unique_ptr<char[]>> blocks; // backing storage for all spellings
+    std::size_t block_used; // number of bytes used in blocks.back()
+
+    std::unique_ptr<boost::string_view[]> segments[NUM_SEGMENTS]; // [symbol id] -> spelling, see locate
+    std::atomic<std::uint32_t> count; // symbols whose spelling can be looked up
+    std::unordered_map<boost::string_view, std::uint32_t, SpellingHash> ids; // spelling -> symbol id
+
+    std::mutex mutex; // taken to intern
+
+    boost::string_view store(const boost::string_view&);
+
+    // the view of a symbol is at offset in segment: with n = id + 2^F, the
+    // segment is the position of n's highest bit less F and the offset is
+    // n without that bit
+    static void locate(std::uint32_t id, unsigned& segment, std::size_t& offset)
+    {
+        std::uint64_t n = static_cast<std::uint64_t>(id) + (1ull << FIRST_SEGMENT_BITS);
+        unsigned high = 63 - __builtin_clzll(n);
+
+        segment = high - FIRST_SEGMENT_BITS;
+        offset = static_cast<std::size_t>(n - (1ull << high));
+    }
+
+public:
+    SymbolPool();
+
+    // returns the id of the spelling, interning it first if it's new
+    std::uint32_t intern(const boost::string_view&);
+
+    boost::string_view spelling(std::uint32_t id) const
+    {
+        unsigned segment;
+        std::size_t offset;
+        locate(id, segment, offset);
+
+        // pairs with the release in intern, for ids handed out on another thread
+        std::uint32_t published = count.load(std::memory_order_acquire);
+        assert(id < published);
+        (void) published;
+
+        return segments[segment][offset];
+    }
+
+    std::size_t size() const
+    {
+        return count.load(std::memory_order_acquire);
+    }
+};
+
+inline SymbolPool& symbolpool()
 {
-    return s1.get_val() == s2.get_val();
+    static SymbolPool pool;
+    return pool;
 }
 
-inline bool operator!=(const Symbol& s1, const Symbol& s2)
+inline boost::string_view Symbol::get_view() const
 {
-    return !(s1.get_val() == s2.get_val());
+    return symbolpool().spelling(id);
 }
 
-inline bool operator<(const Symbol& s1, const Symbol& s2)
+inline std::string Symbol::get_val() const
 {
-    return s1.get_val() < s2.get_val();
+    boost::string_view view = get_view();
+    return std::string(view.data(), view.size());
 }
 
 
 // Generic symbol table that supports scopes
 // Used by the semantic analyzer to enforce scoping rules
 // and is used by the code generator to store variable name
-// to activation record offset
+// to activation record offset.
+//
+// All scopes share one open addressing hash table that maps a key to its
+// innermost binding. Every binding is also pushed onto an undo log which
+// remembers the binding it shadows, so leaving a scope just pops the log
+// back to where the scope started and restores the shadowed bindings.
+// K must be hashable with std::hash
 template<typename K, typename V>
 class SymbolTable
 {
 private:
-    typename std::vector<std::map<K, V>> tbl;
+    static const std::size_t NO_BINDING = static_cast<std::size_t>(-1);
+    static const std::size_t INITIAL_CAPACITY = 64; // must be a power of 2
+
+    struct Slot
+    {
+        K key;
+        bool used;
+        std::size_t binding; // index of the innermost binding in log, or NO_BINDING
+    };
+
+    struct Binding
+    {
+        std::size_t slot; // slot of the bound key in tbl
+        std::size_t shadowed; // binding this one hides, or NO_BINDING
+        std::size_t depth; // scope depth the binding was added in
+        V val;
+    };
+
+    std::vector<Slot> tbl; // open addressing table, linear probing
+    std::size_t keys; // number of used slots in tbl
+    std::vector<Binding> log; // undo log of every live binding, innermost last
+    std::vector<std::size_t> scopes; // size of log when each scope was entered
+
+    std::size_t find_slot(const K& key) const
+    {
+        // multiply by 2^64 / phi so that dense keys, such as symbol ids,
+        // still spread over the whole table
+        std::size_t mask = tbl.size() - 1;
+        std::size_t i = (static_cast<std::uint64_t>(std::hash<K>()(key)) * 11400714819323198485ull) >> 32 & mask;
+
+        while (tbl[i].used && !(tbl[i].key == key))
+            i = (i + 1) & mask;
+
+        return i;
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old(tbl.size() * 2, Slot { K(), false, NO_BINDING });
+        old.swap(tbl);
+
+        for (std::size_t i = 0; i < old.size(); ++i)
+        {
+            if (!old[i].used)
+                continue;
+
+            std::size_t slot = find_slot(old[i].key);
+            tbl[slot] = old[i];
+
+            for (std::size_t b = tbl[slot].binding; b != NO_BINDING; b = log[b].shadowed)
+                log[b].slot = slot;
+        }
+    }
+
+    const Binding* innermost(const K& key) const
+    {
+        const Slot& slot = tbl[find_slot(key)];
+        return slot.used && slot.binding != NO_BINDING ? &log[slot.binding] : nullptr;
+    }
 
 public:
+    SymbolTable()
+        : tbl(INITIAL_CAPACITY, Slot { K(), false, NO_BINDING }), keys(0)
+    {
+
+    }
+
     void enter_scope()
     {
-        tbl.push_back(std::map<K, V>());
+        scopes.push_back(log.size());
     }
 
     void exit_scope()
     {
-        tbl.pop_back();
+        for (std::size_t i = log.size(); i > scopes.back(); --i)
+        {
+            Binding& b = log.back();
+            tbl[b.slot].binding = b.shadowed;
+            log.pop_back();
+        }
+
+        scopes.pop_back();
     }
 
     void add(const K& key, const V& val)
     {
-        tbl.back()[key] = val;
+        std::size_t slot = find_slot(key);
+
+        if (!tbl[slot].used)
+        {
+            // keep the load factor at or below 1/2
+            if ((keys + 1) * 2 > tbl.size())
+            {
+                grow();
+                slot = find_slot(key);
+            }
+
+            tbl[slot] = Slot { key, true, NO_BINDING };
+            ++keys;
+        }
+
+        std::size_t binding = tbl[slot].binding;
+
+        // adding a key twice to the same scope replaces its value
+        if (binding != NO_BINDING && log[binding].depth == scopes.size())
+        {
+            log[binding].val = val;
+            return;
+        }
+
+        log.push_back(Binding { slot, binding, scopes.size(), val });
+        tbl[slot].binding = log.size() - 1;
     }
 
     std::size_t size() const
     {
-        return tbl.back().size();
+        return log.size() - scopes.back();
     }
 
-    boost::optional<V> probe(const K& key) 
+    boost::optional<V> probe(const K& key) const
     {
-        auto last = tbl.back();
-        return last.count(key) > 0 ? boost::optional<V>(last[key]) : boost::optional<V>();
+        const Binding* b = innermost(key);
+        return b && b->depth == scopes.size() ? boost::optional<V>(b->val) : boost::optional<V>();
     }
 
-    boost::optional<V> lookup(const K& key)
+    boost::optional<V> lookup(const K& key) const
     {
-        for (auto it = tbl.rbegin(), end = tbl.rend(); it != end; ++it)
-            if (it->count(key) > 0)
-                return boost::optional<V>((*it)[key]);
-
-        return boost::optional<V>();
+        const Binding* b = innermost(key);
+        return b ? boost::optional<V>(b->val) : boost::optional<V>();
     }
 };
 
@@ -0,0 +1,75 @@
+#include "threadpool.hpp"
+
+#include <utility>
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+    : unfinished(0), stopping(false)
+{
+    if (num_threads == 0)
+        num_threads = 1;
+
+    for (std::size_t i = 0; i < num_threads; ++i)
+        workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    task_ready.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        ++unfinished;
+    }
+
+    task_ready.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    all_done.wait(lock, [this] { return unfinished == 0; });
+}
+
+void ThreadPool::work()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+            // pending tasks are still run when the pool is destroyed
+            if (tasks.empty())
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--unfinished == 0)
+            all_done.notify_all();
+    }
+}
+
+std::size_t ThreadPool::default_size()
+{
+    std::size_t hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
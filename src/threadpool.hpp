@@ -0,0 +1,52 @@
+// Fixed size pool of worker threads.
+// Tasks are run in the order they were submitted, by whichever worker is
+// free first. The pool is used by the front end to work on several files at
+// the same time
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::size_t unfinished; // tasks submitted but not finished yet
+    bool stopping;
+
+    std::mutex mutex;
+    std::condition_variable task_ready;
+    std::condition_variable all_done;
+
+    void work();
+
+public:
+    explicit ThreadPool(std::size_t);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const
+    {
+        return workers.size();
+    }
+
+    void submit(std::function<void()>);
+
+    // blocks until every task submitted so far has finished
+    void wait();
+
+    // number of threads worth using on this machine, at least 1
+    static std::size_t default_size();
+};
+
+#endif
@@ -1,31 +1,24 @@
 #include "tokentable.hpp"
 
-TokenTable::TokenTable()
-    : count(1)
+Symbol LocalTokenTable::add(const boost::string_view& id)
 {
+    auto it = syms.find(id);
+    if (it != end(syms))
+        return it->second;
 
+    Symbol sym(symbolpool().intern(id));
+    syms.emplace(sym.get_view(), sym);
+    return sym;
 }
 
-Symbol TokenTable::add(const std::string& id)
+void LocalTokenTable::clear()
 {
-   if (tbl.count(id) == 0)
-   {
-      tbl[id] = Symbol(id);
-      idx_tbl[id] = count++;
-   }
-
-   return tbl[id];
-}
-
-std::map<std::string, Symbol> TokenTable::get_elems() const
-{
-    return tbl;
+    syms.clear();
 }
 
-int TokenTable::get_idx(const std::string& id) 
+void LocalTokens::clear()
 {
-    if (idx_tbl.count(id) > 0)
-        return idx_tbl[id];
-    else
-        return -1;
+    ids.clear();
+    ints.clear();
+    strings.clear();
 }
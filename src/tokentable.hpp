@@ -2,54 +2,39 @@
 #define TOKENTABLE_H
 
 #include "symboltable.hpp"
-#include <string>
-#include <map>
+#include <unordered_map>
 
-class TokenTable
+// Tokens of one kind seen by one parse. Lexers look spellings up here
+// before going to the symbol pool, so that parses running at the same time
+// only take the lock of the pool the first time they see a spelling.
+// Constants are pooled by node, see constantpool.hpp
+class LocalTokenTable
 {
 private:
-    std::map<std::string, Symbol> tbl;
-    std::map<std::string, int> idx_tbl;
-    int count;
+    std::unordered_map<boost::string_view, Symbol, SpellingHash> syms; // keyed by the spellings in the pool
 
 public:
-    TokenTable();
-    Symbol add(const std::string&);
-    std::map<std::string, Symbol> get_elems() const;
-    int get_idx(const std::string&);
-};
-
-class IdentifierTable : public TokenTable
-{
+    LocalTokenTable() = default;
 
-};
+    LocalTokenTable(const LocalTokenTable&) = delete;
+    LocalTokenTable& operator=(const LocalTokenTable&) = delete;
 
-inline IdentifierTable& idtable()
-{
-    static IdentifierTable idtable;
-    return idtable;
-}
+    // Tokens are interned straight from the lexer's buffer, the spelling is
+    // only copied the first time the pool sees it
+    Symbol add(const boost::string_view&);
 
-class IntTable : public TokenTable
-{
-    
+    void clear();
 };
 
-inline IntTable& inttable()
-{
-    static IntTable inttable;
-    return inttable;
-}
-
-class StringTable : public TokenTable
+// The local tables a lexer adds its identifiers and constants to
+class LocalTokens
 {
+public:
+    LocalTokenTable ids;
+    LocalTokenTable ints;
+    LocalTokenTable strings;
 
+    void clear();
 };
 
-inline StringTable& stringtable()
-{
-    static StringTable stringtable;
-    return stringtable;
-}
-
 #endif 
@@ -1,6 +1,8 @@
 #include "utility.hpp"
 #include "constants.hpp"
 
+#include <iostream>
+
 using namespace constants;
 
 namespace utility
@@ -11,23 +13,23 @@ namespace utility
             class_sym == BOOLEAN || class_sym == STRING;
     }
 
-    void print_error(const AstNodePtr& ast, const std::string& msg)
+    void print_error(const std::string& filename, const std::string& msg)
     {
-        print_error(ast->filename, ast->line_no, msg);
+        print_error(std::cerr, filename, msg);
     }
 
-    void print_error(const std::string& filename, std::size_t line, const std::string& msg)
+    void print_error(std::ostream& os, const std::string& filename, const std::string& msg)
     {
-        std::cerr << filename << ":" << line << ": error: " << msg << "\n";
+        os << filename << ": error: " << msg << "\n";
     }
 
-    void print_error(const std::string& filename, const std::string& msg)
+    void print_error(std::ostream& os, const std::string& filename, std::size_t line, const std::string& msg)
     {
-        std::cerr << filename << ": error: " << msg << "\n";
+        os << filename << ":" << line << ": error: " << msg << "\n";
     }
 
-    void print_error(const AstNode& ast, const std::string& msg)
+    void print_error(std::ostream& os, const SourceManager& sources, const AstNode& ast, const std::string& msg)
     {
-        print_error(ast.filename, ast.line_no, msg);
+        print_error(os, sources.get_filename(ast.loc), sources.get_line(ast.loc), msg);
     }
 }
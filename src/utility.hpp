@@ -2,15 +2,20 @@
 #define UTILITY_H
 
 #include "symboltable.hpp"
+#include "sourcemanager.hpp"
 #include "ast.hpp"
 
+#include <ostream>
+
 namespace utility
 {
     bool is_basic_class(const Symbol&);
-    void print_error(const AstNodePtr&, const std::string&);
-    void print_error(const std::string&, std::size_t, const std::string&);
     void print_error(const std::string&, const std::string&);
-    void print_error(const AstNode&, const std::string&);
+    void print_error(std::ostream&, const std::string&, const std::string&);
+    void print_error(std::ostream&, const std::string&, std::size_t, const std::string&);
+
+    // the node's file is looked up in the sources of its compilation
+    void print_error(std::ostream&, const SourceManager&, const AstNode&, const std::string&);
 }
 
 #endif
@@ -0,0 +1,82 @@
+# Shared by the scripts of the lexer and parser tests, to be sourced.
+# Set COOLC to the compiler to use, otherwise the scripts take the one on
+# the PATH or, for the tests, build one.
+
+TESTSDIR=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+SRCDIR=$TESTSDIR/../src
+corpusfiles=($TESTSDIR/semanticanalyzer/expressions.cl)
+COPIES=${COPIES:-2000}
+
+# Builds coolc in its default configuration with waf and sets COOLC to it,
+# unless COOLC is set already
+build_coolc()
+{
+    if [ -z "$COOLC" ]
+    then
+        (cd "$SRCDIR" && ${WAF:-waf} configure build) > /dev/null || return 1
+        COOLC=$SRCDIR/build/coolc
+    elif [[ $COOLC == */* ]]
+    then
+        COOLC=$(cd "$(dirname "$COOLC")" && pwd)/$(basename "$COOLC")
+    fi
+}
+
+# Makes the temporary directory scratch, which is removed when the script
+# exits
+make_scratch()
+{
+    if [ -z "$scratch" ]
+    then
+        scratch=$(mktemp -d) || exit 1
+        trap 'rm -rf "$scratch"' EXIT
+    fi
+}
+
+# Sets inputs to the files given, or to a temporary file made of COPIES
+# copies of the test programs
+corpus_inputs()
+{
+    if [ $# -gt 0 ]
+    then
+        inputs=("$@")
+        return
+    fi
+
+    make_scratch
+    for ((i = 0; i < COPIES; ++i))
+    do
+        cat "${corpusfiles[@]}"
+    done > "$scratch/corpus.cl"
+    inputs=("$scratch/corpus.cl")
+}
+
+# Compiles every test program with the options given and compares the AST
+# printed with the expected one, returns 1 if any differs
+check_asts()
+{
+    local failed=0
+
+    make_scratch
+    for testfile in "${corpusfiles[@]}"
+    do
+        local base=$(basename -s .cl "$testfile")
+        local output
+
+        if (cd "$scratch" && "$COOLC" "$@" "$testfile" > "$base.out")
+        then
+            output=$(diff "$scratch/$base.out" "${testfile%.cl}.ast")
+        else
+            output="coolc exited with status $?"
+        fi
+
+        if [ -z "$output" ]
+        then
+            echo "Test ${base} $* Passed!"
+        else
+            echo -e "Test ${base} $* Failed!\n$output\n"
+            failed=1
+        fi
+    done
+
+    return $failed
+}
@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# Checks that the flex and hand written lexers produce the same tokens: the
+# test programs are compiled with each of them and their ASTs compared with
+# the expected ones, then --bench-lexer compares the token streams of the
+# two lexers on the test programs and on a large corpus made of copies of
+# them. Exits with 1 if any check fails. Set COOLC to the compiler to test,
+# otherwise the default configuration is built
+source "$(dirname "$0")/../common.sh"
+
+echo -e "======= Testing Lexers =======\n"
+
+if ! build_coolc
+then
+    echo "Building coolc failed"
+    exit 1
+fi
+
+status=0
+check_asts --lexer=flex || status=1
+check_asts --lexer=hand || status=1
+
+corpus_inputs
+if ! "$COOLC" --bench-lexer "${corpusfiles[@]}" "${inputs[@]}" > /dev/null
+then
+    echo "Lexers disagree, see the errors above"
+    status=1
+fi
+
+exit $status
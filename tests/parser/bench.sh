@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# Compares the throughput of the Bison and hand written parsers on a large
+# input made of copies of the test programs, or on the COOL files given as
+# arguments. Exits with coolc's status, which isn't 0 if the parsers
+# disagree. Set COOLC to the compiler to use if it isn't on the PATH
+source "$(dirname "$0")/../common.sh"
+COOLC=${COOLC:-coolc}
+
+echo -e "======= Benchmarking Parsers =======\n"
+
+corpus_inputs "$@"
+$COOLC --bench-parser "${inputs[@]}"
+status=$?
+
+if [ $status -eq 0 ]
+then
+    echo -e "\nParsers agree on all inputs"
+else
+    echo -e "\nParsers disagree, see the errors above"
+fi
+
+exit $status
@@ -0,0 +1,56 @@
+#!/bin/bash
+
+# Checks that the Bison and hand written parsers build the same ASTs: the
+# test programs are compiled with each of them and their ASTs compared with
+# the expected ones, then --bench-parser compares the ASTs the two parsers
+# build for the test programs and for a large corpus made of copies of
+# them, and a method body nested deeper than the Bison parser's initial
+# stack is parsed by both and compared. Exits with 1 if any check fails. Set COOLC to the compiler to test,
+# otherwise the default configuration is built
+source "$(dirname "$0")/../common.sh"
+
+echo -e "======= Testing Parsers =======\n"
+
+if ! build_coolc
+then
+    echo "Building coolc failed"
+    exit 1
+fi
+
+status=0
+check_asts --parser=bison || status=1
+check_asts --parser=hand || status=1
+check_asts --lexer=hand --parser=hand || status=1
+
+corpus_inputs
+if ! "$COOLC" --bench-parser "${corpusfiles[@]}" "${inputs[@]}" > /dev/null
+then
+    echo "Parsers disagree, see the errors above"
+    status=1
+fi
+
+# a thousand parentheses, the Bison parser has to grow its stack
+make_scratch
+parens=$(printf '%1000s' '')
+{
+    echo -e "class Main\n{\n    a:Int <- 0;\n\n    main():Int\n    {"
+    echo "        ${parens// /(}a${parens// /)}"
+    echo -e "    };\n};"
+} > "$scratch/deep.cl"
+
+for parser in bison hand
+do
+    if ! (cd "$scratch" && "$COOLC" --parser=$parser deep.cl > /dev/null)
+    then
+        echo "Test deep --parser=$parser Failed!"
+        status=1
+    fi
+done
+
+if ! "$COOLC" --bench-parser "$scratch/deep.cl" > /dev/null
+then
+    echo "Parsers disagree on deep nesting, see the errors above"
+    status=1
+fi
+
+exit $status